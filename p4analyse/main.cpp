@@ -0,0 +1,108 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+#include "aiSolver.hpp"
+
+
+/// \brief Batch analyser of recorded positions, parallel across positions: each thread takes the next position, searches it alone, and writes its result as soon as it is found
+/// \detail Usage: p4analyse [positions file = - (stdin)] [threads = all] [depth = 0 (solve: exact score)] [table = shared | own] [own table size in MB = 16]
+/// Input: one position per line, the moves played from the empty board (columns [1, 7], format of bitboard::playMoves()), empty lines and lines starting with '#' are ignored
+/// Output (stdout, in the order the results are found): "<moves> <score> <best column> <nodes> <ms>", "<moves> invalid" for positions that cannot be played or whose game is over
+/// The best column is [1, 7], or "-" when the search found no column to play
+/// Summary (stderr): positions/s and nodes/s
+/// Tables: shared, every thread uses p4ai::transpositions (positions of the same games reuse each other's results), own: each thread has a table of its own (see p4ai::threadTable)
+int main(int _argc, char** _argv)
+{
+	std::string inputPath = (_argc > 1) ? std::string(_argv[1]) : std::string("-");
+	uint threadCount = (_argc > 2) ? (uint)std::atoi(_argv[2]) : ff::maxOf(std::thread::hardware_concurrency(), (uint)1);
+	uint depth = (_argc > 3) ? (uint)std::atoi(_argv[3]) : 0;
+	bool ownTables = _argc > 4 && std::strcmp(_argv[4], "own") == 0;
+	uint ownTableMb = (_argc > 5) ? (uint)std::atoi(_argv[5]) : 16;
+	threadCount = ff::maxOf(threadCount, (uint)1);
+
+	// Read every position first (lines are only kept as text, each thread plays its own):
+	std::ifstream file;
+	if (inputPath != "-")
+	{
+		file.open(inputPath);
+		if (!file.is_open()) { std::cerr << "Could not read " << inputPath << "\n"; return 1; }
+	}
+	std::istream& input = (inputPath != "-") ? (std::istream&)file : std::cin;
+
+	std::vector<std::string> positions;
+	std::string line;
+	while (std::getline(input, line))
+	{
+		if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+		if (line.empty() || line[0] == '#') { continue; }
+		positions.push_back(line.substr(0, line.find_first_of(" \t"))); // (<- anything after the moves is ignored, for example a known score)
+	}
+
+	std::cerr << "Analysing " << positions.size() << " positions " << ((depth == 0) ? std::string("to their exact score") : "at depth " + std::to_string(depth)) << " on " << threadCount << " threads, " << (ownTables ? "one table per thread" : "shared table") << "\n";
+
+	std::atomic<uint64> next;
+	std::atomic<uint64> nodes;
+	next.store(0);
+	nodes.store(0);
+	std::mutex outputLock;
+	ff::timer timer;
+
+	std::vector<std::thread> threads;
+	for (uint i = 0; i < threadCount; i += 1)
+	{
+		threads.push_back(std::thread([&]()
+			{
+				std::unique_ptr<p4ai::transpositionTable> table;
+				if (ownTables) { table = std::unique_ptr<p4ai::transpositionTable>(new p4ai::transpositionTable(ownTableMb)); p4ai::threadTable = table.get(); }
+
+				for (uint64 idx = next.fetch_add(1); idx < positions.size(); idx = next.fetch_add(1))
+				{
+					bitboard board;
+					if (!board.playMoves(positions[idx].c_str()) || board.getStatus() != nBoardStatus::playing)
+					{
+						std::lock_guard<std::mutex> lock(outputLock);
+						std::cout << positions[idx] << " invalid\n" << std::flush;
+						continue;
+					}
+
+					ff::timer positionTimer;
+					p4ai::boardEvaluation eval;
+					p4ai::searchStats stats;
+					if (depth == 0)
+					{
+						p4ai::solver solving = p4ai::solver(board);
+						while (!solving.isFinished()) { solving.step(-1); }
+						eval = solving.getBest();
+						stats = solving.stats;
+					}
+					else
+					{
+						p4ai::iterativeSearch search = p4ai::iterativeSearch(board, depth);
+						while (!search.isFinished()) { search.step(-1); }
+						eval = search.getBest();
+						stats = search.stats;
+					}
+					nodes.fetch_add(stats.nodes);
+
+					std::string column = (eval.column < bitboard::xSize) ? std::to_string((int)eval.column + 1) : std::string("-");
+					std::lock_guard<std::mutex> lock(outputLock);
+					std::cout << positions[idx] << " " << (int)eval.score << " " << column << " " << stats.nodes << " " << positionTimer.getMilli() << "\n" << std::flush;
+				}
+
+				p4ai::threadTable = nullptr;
+			}));
+	}
+	for (uint i = 0; i < threads.size(); i += 1) { threads[i].join(); }
+
+	uint timeMs = ff::maxOf(timer.getMilli(), (uint)1);
+	std::cerr << "Analysed " << positions.size() << " positions in " << timeMs << " ms: " << (uint64)positions.size() * 1000 / timeMs << " positions/s, " << nodes.load() * 1000 / timeMs << " nodes/s\n";
+	return 0;
+}
@@ -0,0 +1,485 @@
+#pragma once
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "ff/fflog.hpp"
+#include "ff/fftime.hpp"
+#include "ff/ffdynarray.hpp"
+
+#include "aiParallelSearch.hpp"
+#include "aiSolver.hpp"
+#include "aiTableSnapshot.hpp"
+#include "aiTimeManager.hpp"
+
+namespace p4ai
+{
+	namespace benchmark
+	{
+		/// \brief Measurements of one search
+		struct measure
+		{
+			uint threadCount = 0;
+			uint depth = 0;
+			uint timeMs = 0;
+			uint64 nodes = 0;
+			transpositionTable::counters tableCounters; // (<- every thread)
+			searchStats stats;
+			boardEvaluation eval;
+
+			uint64 getNodesPerSecond() const;
+		};
+
+		/// \brief Search a position until a depth is finished, starting from an empty transposition table and an empty cutoff memory
+		///
+		/// \param _board: The position to search
+		/// \param _depth: The depth the search has to finish
+		/// \param _threadCount: Number of threads used by the search
+		/// \param _mode: How the threads share the work
+		measure searchToDepth(bitboard _board, uint _depth, uint _threadCount, nParallelMode _mode = nParallelMode::lazySmp);
+
+		/// \brief Log how the time to finish a depth and the nodes/s scale from 1 to _maxThreads threads (summed over every position)
+		void logThreadScaling(const ff::dynarray<bitboard>& _boards, uint _depth, uint _maxThreads, nParallelMode _mode = nParallelMode::lazySmp);
+
+		/// \brief Log how the transposition table is used by a single thread search of every position (hits, collisions, overwrites)
+		void logTranspositionUsage(const ff::dynarray<bitboard>& _boards, uint _depth);
+
+		/// \brief Log the nodes and time a single thread search of every position takes with each move ordering (see nMoveOrdering)
+		void logMoveOrdering(const ff::dynarray<bitboard>& _boards, uint _depth);
+
+		/// \brief Log the nodes and time a single thread search of every position takes with and without killer moves and history (see useMoveHistory)
+		void logMoveHistory(const ff::dynarray<bitboard>& _boards, uint _depth);
+
+		/// \brief Log how much a table snapshot speeds up a restarted program (see saveTableSnapshot()): every position is searched from an empty table (cold), the table is saved, cleared and loaded back, then every position is searched again (warm)
+		///
+		/// \param _path: Snapshot file written and read by the benchmark (removed afterwards)
+		void logWarmStart(const ff::dynarray<bitboard>& _boards, uint _depth, const ff::string& _path);
+
+
+		/// \brief Position of a benchmark set, with its known exact score
+		struct scoredPosition
+		{
+			ff::string moves;	// columns [1, 7] played from the empty board (format of bitboard::playMoves())
+			bitboard board;
+			int score = 0;		// exact score (see solve())
+		};
+
+		/// \brief Load a position file: one "<moves> <exact score>" per line, empty lines and lines starting with '#' are ignored
+		///
+		/// \param _path: Path of the file
+		/// \param _positions: RETURN VALUE of the positions of the file, added after the ones already in it
+		///
+		/// \return [true: the file was read] [false: the file could not be opened, or a line is invalid (the positions before it are kept)]
+		bool loadScoredPositions(const ff::string& _path, ff::dynarray<scoredPosition>& _positions);
+
+		/// \brief Solve a position, starting from an empty transposition table, an empty cutoff memory and an empty proof-number table
+		///
+		/// \param _board: The position to solve
+		/// \param _pool: Threads sharing the exploration (nullptr: explore on the current thread only)
+		/// \param _timeoutMs: Time budget, the evaluation is aborted if the solver runs out of it
+		/// \param _proofNodes: Proof-number budget of the solver (see solver::proofNodes, 0: null-window searches only)
+		measure solveToEnd(bitboard _board, workStealingPool* _pool, uint _timeoutMs, uint64 _proofNodes = 0);
+
+		/// \brief Find out if the player to move wins with one null-window search around 0 (negamax, single thread), starting from an empty transposition table and an empty cutoff memory
+		/// \detail eval: exhaustive with a score above 0 if the player to move wins, exhaustive with a score of 0 or less otherwise, aborted if out of time
+		measure searchWin(bitboard _board, uint _timeoutMs);
+
+		/// \brief Find out if the player to move wins with a proof-number search, starting from an empty proof-number table
+		/// \detail eval: exhaustive with a score of 1 and the winning column if the win is proven, exhaustive with a score of 0 if it is disproven, aborted if out of nodes or time
+		measure proveWinToEnd(bitboard _board, uint64 _maxNodes, uint _timeoutMs);
+
+		/// \brief Get a percentile of values (nearest rank)
+		///
+		/// \param _values: The values, in any order
+		/// \param _percent: The percentile [0, 100]
+		uint getPercentile(const ff::dynarray<uint>& _values, uint _percent);
+
+		/// \brief Solve every position of a set with the same settings, log the time (mean and percentiles), nodes and nodes/s, and every position whose exact score was not found
+		///
+		/// \param _name: Name of the set (for logs)
+		/// \param _positions: The positions and their exact scores
+		/// \param _threadCount: Number of threads used by the solver
+		/// \param _timeoutMs: Time budget of each position
+		///
+		/// \return The number of failed positions (wrong score, or not solved in time)
+		uint logSolvedSet(const ff::string& _name, const ff::dynarray<scoredPosition>& _positions, uint _threadCount, uint _timeoutMs);
+
+		/// \brief Compare the proof-number search to the negamax search on every position of a set (single thread): nodes and time to find out who wins, then nodes and time to solve with and without proof-number searches first
+		/// \detail Every result is checked against the known exact score, a proof-number search that runs out of nodes is not a failure (the solver falls back to its null-window searches)
+		///
+		/// \param _name: Name of the set (for logs)
+		/// \param _positions: The positions and their exact scores
+		/// \param _maxNodes: Node budget of the proof-number searches
+		/// \param _timeoutMs: Time budget of each search
+		///
+		/// \return The number of failed positions (wrong result, or not found in time)
+		uint logProofNumberSet(const ff::string& _name, const ff::dynarray<scoredPosition>& _positions, uint64 _maxNodes, uint _timeoutMs);
+
+		/// \brief Check the transitions of the time manager on a scripted sequence of finished depths (no search, the budget is too large for the clock to reach a limit during the checks)
+		/// \detail A dropped score extends both limits, a proven loss does not stop the move, a proven win does, a stable column shortens the soft limit, a zero budget leaves no time
+		///
+		/// \param _checkCount: RETURN VALUE of the number of checks
+		///
+		/// \return The number of failed checks
+		uint logTimeManagerChecks(uint& _checkCount);
+	}
+}
+
+
+
+uint64 p4ai::benchmark::measure::getNodesPerSecond() const { return nodes * 1000 / ff::maxOf(timeMs, (uint)1); }
+p4ai::benchmark::measure p4ai::benchmark::searchToDepth(bitboard _board, uint _depth, uint _threadCount, nParallelMode _mode)
+{
+	transpositions.clear();
+	cutoffMemory.clear();
+	startNewMoveHistoryAge(); // (<- clears the killer moves of the other threads)
+
+	measure result;
+	result.threadCount = _threadCount;
+	result.depth = _depth;
+
+	ff::timer timer;
+	parallelSearch search = parallelSearch(_board, _depth, _threadCount, _mode);
+	while (!search.isFinished()) { search.step(60000); } // (<- long steps: a step that times out restarts its depth)
+
+	result.timeMs = timer.getMilli();
+	result.stats = search.getStats();
+	result.nodes = result.stats.nodes;
+	result.tableCounters = result.stats.table;
+	result.eval = search.getBest();
+	return result;
+}
+void p4ai::benchmark::logThreadScaling(const ff::dynarray<bitboard>& _boards, uint _depth, uint _maxThreads, nParallelMode _mode)
+{
+	ff::log() << "Thread scaling (" << getParallelModeName(_mode) << "), " << _boards.size() << " positions searched to depth " << _depth << ":\n";
+
+	uint singleThreadMs = 0;
+	for (uint threads = 1; threads <= _maxThreads; threads += 1)
+	{
+		measure total;
+		for (uint i = 0; i < _boards.size(); i += 1)
+		{
+			measure position = searchToDepth(_boards[i], _depth, threads, _mode);
+			total.timeMs += position.timeMs;
+			total.nodes += position.nodes;
+		}
+		if (threads == 1) { singleThreadMs = total.timeMs; }
+
+		ff::log() << "  " << threads << " thread(s): " << total.timeMs << " ms, " << total.nodes << " nodes, " << total.getNodesPerSecond() << " nodes/s, time-to-depth speed-up x" << (float)singleThreadMs / (float)ff::maxOf(total.timeMs, (uint)1) << "\n";
+	}
+}
+void p4ai::benchmark::logTranspositionUsage(const ff::dynarray<bitboard>& _boards, uint _depth)
+{
+	measure total;
+	for (uint i = 0; i < _boards.size(); i += 1)
+	{
+		measure position = searchToDepth(_boards[i], _depth, 1);
+		total.timeMs += position.timeMs;
+		total.nodes += position.nodes;
+		total.tableCounters += position.tableCounters;
+	}
+
+	const transpositionTable::counters& counters = total.tableCounters;
+	ff::log() << "Transposition table (" << (uint)(transpositions.getSizeBytes() / (1024 * 1024)) << " MB, " << transpositions.getBucketCount() << " buckets), " << _boards.size() << " positions searched to depth " << _depth << ":\n";
+	ff::log() << "  " << total.timeMs << " ms, " << total.nodes << " nodes, " << counters.probes << " probes, " << counters.hits << " hits (" << (float)counters.hits * 100.0f / (float)ff::maxOf(counters.probes, (uint64)1) << "%), " << counters.collisions << " collisions\n";
+	ff::log() << "  " << counters.stores << " stores, " << counters.overwrites << " overwrites\n";
+}
+void p4ai::benchmark::logMoveOrdering(const ff::dynarray<bitboard>& _boards, uint _depth)
+{
+	ff::log() << "Move ordering, " << _boards.size() << " positions searched to depth " << _depth << ":\n";
+
+	nMoveOrdering previousOrdering = moveOrdering;
+	nMoveOrdering orderings[2] = { nMoveOrdering::centerFirst, nMoveOrdering::threatCount };
+	const char* names[2] = { "center first", "threat count" };
+	for (uint i = 0; i < 2; i += 1)
+	{
+		moveOrdering = orderings[i];
+		measure total;
+		for (uint j = 0; j < _boards.size(); j += 1)
+		{
+			measure position = searchToDepth(_boards[j], _depth, 1);
+			total.timeMs += position.timeMs;
+			total.nodes += position.nodes;
+			total.stats += position.stats;
+		}
+		ff::log() << "  " << names[i] << ": " << total.timeMs << " ms, " << total.nodes << " nodes, " << total.getNodesPerSecond() << " nodes/s, first move cutoffs " << total.stats.getFirstMoveCutoffRate() << "%\n";
+	}
+	moveOrdering = previousOrdering;
+}
+void p4ai::benchmark::logMoveHistory(const ff::dynarray<bitboard>& _boards, uint _depth)
+{
+	ff::log() << "Killer moves and history, " << _boards.size() << " positions searched to depth " << _depth << ":\n";
+
+	bool previousUse = useMoveHistory;
+	const char* names[2] = { "off", "on" };
+	for (uint i = 0; i < 2; i += 1)
+	{
+		useMoveHistory = (i == 1);
+		measure total;
+		for (uint j = 0; j < _boards.size(); j += 1)
+		{
+			measure position = searchToDepth(_boards[j], _depth, 1);
+			total.timeMs += position.timeMs;
+			total.nodes += position.nodes;
+			total.stats += position.stats;
+		}
+		ff::log() << "  " << names[i] << ": " << total.timeMs << " ms, " << total.nodes << " nodes, " << total.getNodesPerSecond() << " nodes/s, first move cutoffs " << total.stats.getFirstMoveCutoffRate() << "%\n";
+	}
+	useMoveHistory = previousUse;
+}
+void p4ai::benchmark::logWarmStart(const ff::dynarray<bitboard>& _boards, uint _depth, const ff::string& _path)
+{
+	ff::log() << "Warm start from a table snapshot, " << _boards.size() << " positions searched to depth " << _depth << ":\n";
+
+	transpositions.clear();
+	measure runs[2]; // (<- cold, then warm)
+	for (uint run = 0; run < 2; run += 1)
+	{
+		cutoffMemory.clear();
+		startNewMoveHistoryAge();
+		if (run == 1)
+		{
+			// Restart: save the table, clear it and load it back
+			ff::timer saveTimer;
+			uint64 saved = saveTableSnapshot(transpositions, _path);
+			uint saveMs = saveTimer.getMilli();
+			transpositions.clear();
+
+			ff::timer loadTimer;
+			uint64 loaded = loadTableSnapshot(transpositions, _path);
+			uint loadMs = loadTimer.getMilli();
+			ff::log() << "  snapshot: " << saved << " exact entries (" << saved * sizeof(uint64) / 1024 << " KB), saved in " << saveMs << " ms, " << loaded << " loaded in " << loadMs << " ms\n";
+		}
+
+		for (uint i = 0; i < _boards.size(); i += 1)
+		{
+			ff::timer timer;
+			iterativeSearch search = iterativeSearch(_boards[i], _depth);
+			while (!search.isFinished()) { search.step(60000); }
+			runs[run].timeMs += timer.getMilli();
+			runs[run].nodes += search.stats.nodes;
+		}
+		ff::log() << ((run == 0) ? "  cold: " : "  warm: ") << runs[run].timeMs << " ms, " << runs[run].nodes << " nodes\n";
+	}
+	std::remove(_path.data());
+}
+bool p4ai::benchmark::loadScoredPositions(const ff::string& _path, ff::dynarray<scoredPosition>& _positions)
+{
+	std::ifstream file(_path.data());
+	if (!file.is_open()) { return false; }
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (!line.empty() && line.back() == '\r') { line.pop_back(); } // (<- files saved with Windows line endings)
+		if (line.empty() || line[0] == '#') { continue; }
+
+		std::string::size_type separator = line.find(' ');
+		if (separator == std::string::npos) { return false; }
+
+		scoredPosition position;
+		position.moves = line.substr(0, separator);
+		position.score = std::atoi(line.c_str() + separator + 1);
+		if (!position.board.playMoves(position.moves.data())) { return false; }
+		_positions.pushback(position);
+	}
+	return true;
+}
+p4ai::benchmark::measure p4ai::benchmark::solveToEnd(bitboard _board, workStealingPool* _pool, uint _timeoutMs, uint64 _proofNodes)
+{
+	transpositions.clear();
+	cutoffMemory.clear();
+	proofNumbers.clear();
+	startNewMoveHistoryAge(); // (<- clears the killer moves of the other threads)
+
+	measure result;
+	result.threadCount = (_pool != nullptr) ? _pool->getThreadCount() : 1;
+	result.depth = _board.getTurnsLeft();
+
+	ff::timer timer;
+	solver solving = solver(_board);
+	solving.pool = _pool;
+	solving.proofNodes = _proofNodes;
+	while (!solving.isFinished() && !timer.waitedForMilli(_timeoutMs)) { solving.step(_timeoutMs - ff::minOf(timer.getMilli(), _timeoutMs)); }
+
+	result.timeMs = timer.getMilli();
+	result.stats = solving.stats;
+	result.nodes = result.stats.nodes;
+	result.tableCounters = result.stats.table;
+	result.eval = solving.getBest();
+	return result;
+}
+uint p4ai::benchmark::getPercentile(const ff::dynarray<uint>& _values, uint _percent)
+{
+	if (_values.size() == 0) { return 0; }
+
+	std::vector<uint> sorted;
+	for (uint i = 0; i < _values.size(); i += 1) { sorted.push_back(_values[i]); }
+	std::sort(sorted.begin(), sorted.end());
+
+	uint rank = (_percent * sorted.size() + 99) / 100; // (<- smallest value that at least _percent% of the values are lower or equal to)
+	return sorted[ff::maxOf(rank, (uint)1) - 1];
+}
+uint p4ai::benchmark::logSolvedSet(const ff::string& _name, const ff::dynarray<scoredPosition>& _positions, uint _threadCount, uint _timeoutMs)
+{
+	std::unique_ptr<workStealingPool> pool;
+	if (_threadCount > 1) { pool = std::unique_ptr<workStealingPool>(new workStealingPool(_threadCount)); }
+
+	measure total;
+	ff::dynarray<uint> times;
+	uint failed = 0;
+	for (uint i = 0; i < _positions.size(); i += 1)
+	{
+		measure position = solveToEnd(_positions[i].board, pool.get(), _timeoutMs);
+		total.timeMs += position.timeMs;
+		total.nodes += position.nodes;
+		times.pushback(position.timeMs);
+
+		bool solved = position.eval.type == nEvaluation::exhaustive;
+		if (solved && position.eval.score == _positions[i].score) { continue; }
+		failed += 1;
+		ff::log() << "  FAIL " << _name << " " << _positions[i].moves << ": expected " << _positions[i].score << ", found " << (int)position.eval.score << (solved ? "" : " (not solved in time)") << "\n";
+	}
+
+	uint count = _positions.size();
+	ff::log() << "  " << _name << ": " << count - failed << "/" << count << " passed, time mean " << total.timeMs / ff::maxOf(count, (uint)1) << " ms, p50 " << getPercentile(times, 50) << " ms, p90 " << getPercentile(times, 90) << " ms, p99 " << getPercentile(times, 99) << " ms, ";
+	ff::log() << "nodes mean " << total.nodes / ff::maxOf(count, (uint)1) << ", " << total.getNodesPerSecond() << " nodes/s\n";
+	return failed;
+}
+p4ai::benchmark::measure p4ai::benchmark::searchWin(bitboard _board, uint _timeoutMs)
+{
+	transpositions.clear();
+	cutoffMemory.clear();
+	startNewMoveHistoryAge();
+
+	measure result;
+	result.threadCount = 1;
+	result.depth = _board.getTurnsLeft();
+
+	ff::timer timer;
+	searchStats statsStart = getThreadStats();
+	result.eval = getPositionScoreNegamaxStart(_board, _board.getTurnsLeft(), _timeoutMs, ff::interval<int>(0, 2)); // (<- window [0, 1]: above 0 is a win)
+
+	result.timeMs = timer.getMilli();
+	result.stats = getThreadStats() - statsStart;
+	result.nodes = result.stats.nodes;
+	result.tableCounters = result.stats.table;
+	return result;
+}
+p4ai::benchmark::measure p4ai::benchmark::proveWinToEnd(bitboard _board, uint64 _maxNodes, uint _timeoutMs)
+{
+	proofNumbers.clear();
+
+	measure result;
+	result.threadCount = 1;
+	result.depth = _board.getTurnsLeft();
+
+	ff::timer timer;
+	proofNumberSearch search = proofNumberSearch(_board, false, _maxNodes);
+	while (!search.isFinished() && !timer.waitedForMilli(_timeoutMs)) { search.step(_timeoutMs - ff::minOf(timer.getMilli(), _timeoutMs)); }
+
+	result.timeMs = timer.getMilli();
+	result.stats = search.stats;
+	result.nodes = result.stats.nodes;
+	result.eval = boardEvaluation(nEvaluation::aborted);
+	if (search.result != nProof::unknown)
+	{
+		result.eval = boardEvaluation(nEvaluation::exhaustive, (int8)((search.result == nProof::proven) ? 1 : 0), (uint8)_board.getTurnsLeft());
+		result.eval.column = search.column;
+	}
+	return result;
+}
+uint p4ai::benchmark::logProofNumberSet(const ff::string& _name, const ff::dynarray<scoredPosition>& _positions, uint64 _maxNodes, uint _timeoutMs)
+{
+	// Who wins, then exact score: negamax alone (0), with proof-number searches (1)
+	measure wins[2];
+	measure solves[2];
+	uint undecided = 0;
+	uint failed = 0;
+	for (uint i = 0; i < _positions.size(); i += 1)
+	{
+		bool isWin = _positions[i].score > 0;
+		measure runs[4] = { searchWin(_positions[i].board, _timeoutMs), proveWinToEnd(_positions[i].board, _maxNodes, _timeoutMs), solveToEnd(_positions[i].board, nullptr, _timeoutMs), solveToEnd(_positions[i].board, nullptr, _timeoutMs, _maxNodes) };
+		for (uint run = 0; run < 4; run += 1)
+		{
+			measure& total = (run < 2) ? wins[run] : solves[run - 2];
+			total.timeMs += runs[run].timeMs;
+			total.nodes += runs[run].nodes;
+			total.stats.interiorNodes += runs[run].stats.interiorNodes;
+		}
+
+		// Checks (a proven win also needs a column that keeps it):
+		const char* failure = nullptr;
+		if (runs[0].eval.type != nEvaluation::exhaustive || (runs[0].eval.score > 0) != isWin) { failure = "negamax win search"; }
+		if (runs[1].eval.type != nEvaluation::exhaustive) { undecided += 1; }
+		else if ((runs[1].eval.score > 0) != isWin) { failure = "proof-number search"; }
+		else if (isWin)
+		{
+			bitboard next = _positions[i].board;
+			next.play(runs[1].eval.column);
+			if (next.getLastMoveStatus() == nBoardStatus::playing && solveToEnd(next, nullptr, _timeoutMs).eval.score >= 0) { failure = "proof-number column"; }
+		}
+		if (runs[2].eval.type != nEvaluation::exhaustive || runs[2].eval.score != _positions[i].score) { failure = "solver"; }
+		if (runs[3].eval.type != nEvaluation::exhaustive || runs[3].eval.score != _positions[i].score) { failure = "solver with proof-number searches"; }
+		if (failure == nullptr) { continue; }
+		failed += 1;
+		ff::log() << "  FAIL " << _name << " " << _positions[i].moves << " (exact score " << _positions[i].score << "): " << failure << "\n";
+	}
+
+	uint count = _positions.size();
+	ff::log() << "  " << _name << ": " << count - failed << "/" << count << " passed, " << undecided << " out of proof-number budget (" << _maxNodes << " nodes)\n";
+	ff::log() << "    who wins, negamax: " << wins[0].nodes << " nodes (" << wins[0].stats.interiorNodes << " expanded), " << wins[0].timeMs << " ms\n";
+	ff::log() << "    who wins, proof-number: " << wins[1].nodes << " nodes (" << wins[1].stats.interiorNodes << " expanded), " << wins[1].timeMs << " ms\n";
+	ff::log() << "    exact score, solver: " << solves[0].nodes << " nodes, " << solves[0].timeMs << " ms\n";
+	ff::log() << "    exact score, solver with proof-number searches first: " << solves[1].nodes << " nodes, " << solves[1].timeMs << " ms\n";
+	return failed;
+}
+uint p4ai::benchmark::logTimeManagerChecks(uint& _checkCount)
+{
+	const uint budgetMs = 600000;
+	bitboard empty;
+	uint failed = 0;
+	_checkCount = 0;
+	auto check = [&](bool _passed, const char* _name)
+		{
+			_checkCount += 1;
+			if (_passed) { return; }
+			failed += 1;
+			ff::log() << "  FAIL time manager: " << _name << "\n";
+		};
+	auto finishedDepth = [](int _score, uint8 _column, uint _depth)
+		{
+			boardEvaluation eval = boardEvaluation(nEvaluation::exhaustive, (int8)_score, (uint8)_depth);
+			eval.column = _column;
+			return eval;
+		};
+
+	// Score drop, proven loss, proven win:
+	timeManager time = timeManager(empty, budgetMs);
+	check(!time.shouldStop(true), "a new move stops");
+	time.update(finishedDepth(0, 3, 1), 1);
+	check(time.getAdjustedSoftLimitMs() == time.softLimitMs && !time.shouldStop(true), "a first depth changes the limits");
+	time.update(finishedDepth(-2, 3, 2), 2);
+	check(time.getAdjustedSoftLimitMs() == time.softLimitMs + time.softLimitMs / 2, "a dropped score does not extend the soft limit");
+	check(time.getAdjustedHardLimitMs() == time.hardLimitMs + time.hardLimitMs / 2 && time.getRemainingMs() > time.hardLimitMs, "a dropped score does not extend the hard limit");
+	time.update(finishedDepth(-5, 2, 3), 3);
+	check(!time.shouldStop(true), "a proven loss stops the move");
+	time.update(finishedDepth(4, 2, 4), 4);
+	check(time.shouldStop(false), "a proven win does not stop the move");
+	check(time.getRemainingMs() <= time.hardLimitMs, "a rising score keeps the extension");
+
+	// Stable column:
+	timeManager stable = timeManager(empty, budgetMs);
+	for (uint depth = 1; depth <= timeManager::stableDepthsToShorten + 1; depth += 1) { stable.update(finishedDepth(0, 3, depth), depth); }
+	check(stable.getAdjustedSoftLimitMs() == stable.softLimitMs / 2, "a stable column does not shorten the soft limit");
+
+	// No budget:
+	timeManager none = timeManager(empty, 0);
+	check(none.getRemainingMs() == 0, "a zero budget leaves time to search");
+
+	ff::log() << "  time manager: " << _checkCount - failed << "/" << _checkCount << " checks passed\n";
+	return failed;
+}
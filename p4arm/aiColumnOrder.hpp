@@ -9,10 +9,10 @@ namespace p4ai
 	struct columnOrder
 	{
 		uint8 columnIdx[7] = { 255, 255, 255, 255, 255, 255, 255 };
-		int8 columnScore[7] = { -1, -1, -1, -1, -1, -1, -1 };
+		int columnScore[7] = { -1, -1, -1, -1, -1, -1, -1 };
 		uint8 currentSize = 0;
 
-		void addColumn(uint8 _columnIdx, int8 _columnScore, uint _maxColumns = 7);
+		void addColumn(uint8 _columnIdx, int _columnScore, uint _maxColumns = 7);
 		uint8 size();
 		uint8 operator[](uint _idx) const;
 	};
@@ -21,7 +21,7 @@ namespace p4ai
 
 
 uint8 p4ai::columnOrder::operator[](uint _idx) const { return columnIdx[_idx]; }
-void p4ai::columnOrder::addColumn(uint8 _columnIdx, int8 _columnScore, uint _maxColumns)
+void p4ai::columnOrder::addColumn(uint8 _columnIdx, int _columnScore, uint _maxColumns)
 {
 	if (size() >= _maxColumns) { return; }
 
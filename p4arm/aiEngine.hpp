@@ -0,0 +1,421 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+#include "ff/fftime.hpp"
+
+#include "aiParallelSearch.hpp"
+#include "aiOpeningBook.hpp"
+#include "aiSolver.hpp"
+#include "aiTimeManager.hpp"
+
+namespace p4ai
+{
+	/// \brief State of a search submitted to the engine (pending, running, finished, cancelled):
+	/// - pending: the search is waiting for the worker thread to pick it up
+	/// - running: the worker thread is exploring the position, partial results can be polled
+	/// - finished: the search explored every wanted depth, solved its position, or its time manager decided to play (see timeManager)
+	/// - cancelled: the search was cancelled or replaced by a newer search
+	enum class nSearchState : char { pending, running, finished, cancelled };
+
+	/// \brief Id given when submitting a search, used to poll or cancel it
+	typedef uint searchHandle;
+
+	/// \brief Search engine running on its own worker thread, so that the UI / camera loop never waits on a search
+	/// \detail Only one search runs at a time: submitting a new search cancels the previous one
+	/// When no search is running, the engine can ponder: it explores the positions the opponent can reach from the current board, filling the transposition table in advance
+	struct engine
+	{
+		/// \brief Time given to each step of the iterative search, progress is kept in the transposition table between slices (also how long a cancel can take to be noticed)
+		static const uint sliceMs = 50;
+
+		std::thread worker;
+		std::mutex mtx;
+		std::condition_variable wakeUp;
+		std::atomic<bool> stopWorker;
+		std::atomic<bool> abortRunning;	// stops the slice the worker is exploring within a node when set: a newer search, a cancel, or the destructor (see abortSignal)
+
+		uint threadCount = 1;			// threads used by each search (see setThreadCount, defaults to every core but one, left for the UI and camera)
+		nParallelMode parallelMode = nParallelMode::lazySmp;	// how the threads of a search share the work (see setParallelMode)
+		bool solveMode = false;			// searches find the exact score instead of exploring to their wanted depth (see setSolveMode)
+		uint64 proofNodes = 0;			// proof-number budget of each solve (0: null-window searches only, see setProofNodes)
+
+		searchHandle lastHandle = 0;
+		nSearchState state = nSearchState::cancelled;
+		boardEvaluation result;
+		principalVariation resultLine;	// line expected after the board of the search, starting with the column of result
+		searchStats resultStats;		// measurements of the search so far
+
+		bitboard board;
+		uint wantedDepth = 0;
+		uint moveBudgetMs = 0;			// nominal thinking budget of the move (see timeManager)
+		uint64 maxNodes = 0;			// node budget of the search, shared by its threads (0: no limit, see searchNodeLimit)
+
+		bool pondering = false;			// set by ponder(), cleared by start()
+		bool ponderFinished = false;	// every reply of ponderBoard is explored to ponderDepth: ponder() with the same board and depth does not restart (cleared by a new board or depth, start() and newGame())
+		bitboard ponderBoard;			// board the opponent has to play on
+		uint ponderDepth = 0;
+		uint ponderRequest = 0;			// incremented every time the pondered board changes
+
+		// (worker thread only:)
+		uint ponderStarted = 0;			// last ponder request the searches were created for
+		iterativeSearch ponderSearches[7];	// one search per opponent reply, indexed by column
+		bool ponderActive[7] = { false, false, false, false, false, false, false };
+		uint ponderNext = 0;			// next reply to explore (replies are explored in turns)
+		std::shared_ptr<workStealingPool> pool;	// threads helping the worker thread, kept between slices and searches so that their thread_local tables and statistics carry over (see updatePool)
+
+		engine();
+		~engine();
+
+		/// \brief Submit a position to search, cancels the previous search if it is still running
+		///
+		/// \param _board: The position to search
+		/// \param _wantedDepth: How deep to explore for moves (depths are explored one after the other up to this one)
+		/// \param _moveBudgetMs: Nominal thinking budget of the move, spent once by the whole search (a time manager scales it with the moves left and stops early on stable or won positions, see timeManager)
+		/// \param _maxNodes: Nodes the search can explore on all its threads before it plays its last finished depth (0: no limit, see searchNodeLimit)
+		///
+		/// \return Handle used to poll or cancel the search
+		searchHandle start(bitboard _board, uint _wantedDepth, uint _moveBudgetMs, uint64 _maxNodes = 0);
+
+		/// \brief Get the state of a search without blocking
+		///
+		/// \param _handle: Handle returned by start()
+		/// \param _result: RETURN VALUE of the latest evaluation (partial while running, final once finished)
+		/// \param _line: RETURN VALUE of the line the latest evaluation expects, starting with its column (nullptr: not needed)
+		/// \param _stats: RETURN VALUE of the measurements of the search so far (nullptr: not needed)
+		///
+		/// \return The state of the search (a handle that was replaced by a newer search is cancelled)
+		nSearchState poll(searchHandle _handle, boardEvaluation& _result, principalVariation* _line = nullptr, searchStats* _stats = nullptr);
+
+		/// \brief Cancel a search (does nothing if the handle was already replaced by a newer search)
+		/// \detail The search is aborted right away, without waiting for the end of its slice
+		void cancel(searchHandle _handle);
+
+		/// \brief Ponder while the opponent is thinking: explore every reply of the opponent in turns until start() is called
+		/// \detail Calling it again with the same board keeps pondering, calling it with a new board restarts pondering
+		/// If the board follows the line of the last search, the reply that line expects is explored first, along the rest of the line
+		/// If the position given to start() is one of the explored replies, the search continues from where pondering stopped
+		///
+		/// \param _board: The board the opponent has to play on
+		/// \param _wantedDepth: How deep to explore each reply
+		void ponder(bitboard _board, uint _wantedDepth);
+
+		/// \brief Start a new game: cancel the running search and pondering, the entries of the previous games become stale in the transposition table (see transpositionTable::startNewGeneration())
+		void newGame();
+
+		/// \brief Set how many threads explore each search, and how many opponent replies are pondered at the same time
+		/// \detail Applies to the next search, the worker thread counts as one of them
+		///
+		/// \param _threadCount: Number of threads [1, ...]
+		void setThreadCount(uint _threadCount);
+
+		/// \brief Set how the threads of each search share the work (pondering always explores one reply per thread)
+		/// \detail Applies to the next search
+		void setParallelMode(nParallelMode _mode);
+
+		/// \brief Set if searches find the exact score of their position (explored until the end of the game, the wanted depth is ignored), or explore to their wanted depth
+		/// \detail Applies to the next search, a solve that runs out of its time budget gives its best proven column
+		void setSolveMode(bool _solve);
+
+		/// \brief Set the node budget of the proof-number searches run before the null-window searches of each solve (see solver::proofNodes)
+		/// \detail Off by default: faster on positions decided by threats (a won position has a winning column almost right away), slower on tight end games, single thread
+		///
+		/// \param _proofNodes: Nodes per proof-number search (0: none, solver::defaultProofNodes: a few tens of milliseconds)
+		void setProofNodes(uint64 _proofNodes);
+
+		/// \brief Worker thread loop, waits for submitted searches and runs them, ponders in between
+		void run();
+
+		/// \brief Run the submitted search (worker thread only, called with the lock held)
+		void runSearch(std::unique_lock<std::mutex>& _lock);
+
+		/// \brief Solve the submitted search (worker thread only, called with the lock held)
+		void runSolve(std::unique_lock<std::mutex>& _lock, searchHandle _handle, bitboard _board, const timeManager& _time);
+
+		/// \brief Explore the next opponent reply for one slice (worker thread only, called with the lock held)
+		void runPonderStep(std::unique_lock<std::mutex>& _lock);
+
+		/// \brief Create the pool again if the thread count changed since it was created (worker thread only, called with the lock held)
+		void updatePool();
+	};
+
+
+	/// \brief Engine used by the state machine
+	engine searchEngine;
+}
+
+
+
+p4ai::engine::engine()
+{
+	stopWorker.store(false);
+	abortRunning.store(false);
+	threadCount = ff::maxOf(std::thread::hardware_concurrency(), (uint)2) - 1;
+}
+p4ai::engine::~engine()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		stopWorker.store(true);
+		abortRunning.store(true);
+	}
+	wakeUp.notify_all();
+	if (worker.joinable()) { worker.join(); }
+}
+p4ai::searchHandle p4ai::engine::start(bitboard _board, uint _wantedDepth, uint _moveBudgetMs, uint64 _maxNodes)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+
+	if (!worker.joinable()) { worker = std::thread(&engine::run, this); } // (<- worker is started on first use)
+
+	lastHandle += 1;
+	abortRunning.store(true); // (<- the previous search or pondering stops right away)
+	state = nSearchState::pending;
+	pondering = false;
+	ponderFinished = false;
+	result = boardEvaluation(nEvaluation::aborted);
+	resultLine = principalVariation();
+	resultStats = searchStats();
+	board = _board;
+	wantedDepth = _wantedDepth;
+	moveBudgetMs = _moveBudgetMs;
+	maxNodes = _maxNodes;
+
+	wakeUp.notify_all();
+	return lastHandle;
+}
+p4ai::nSearchState p4ai::engine::poll(searchHandle _handle, boardEvaluation& _result, principalVariation* _line, searchStats* _stats)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+
+	if (_handle != lastHandle) { return nSearchState::cancelled; }
+	_result = result;
+	if (_line != nullptr) { *_line = resultLine; }
+	if (_stats != nullptr) { *_stats = resultStats; }
+	return state;
+}
+void p4ai::engine::cancel(searchHandle _handle)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+
+	if (_handle != lastHandle) { return; }
+	if (state == nSearchState::pending || state == nSearchState::running) { state = nSearchState::cancelled; abortRunning.store(true); }
+}
+void p4ai::engine::ponder(bitboard _board, uint _wantedDepth)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+
+	if (state == nSearchState::pending || state == nSearchState::running) { return; } // (<- a search has priority over pondering)
+	if ((pondering || ponderFinished) && ponderBoard == _board && ponderDepth == _wantedDepth) { return; } // (<- still pondering this board, or already explored it in full)
+
+	if (!worker.joinable()) { worker = std::thread(&engine::run, this); } // (<- worker is started on first use)
+
+	pondering = true;
+	ponderFinished = false;
+	ponderBoard = _board;
+	ponderDepth = _wantedDepth;
+	ponderRequest += 1;
+
+	wakeUp.notify_all();
+}
+void p4ai::engine::newGame()
+{
+	std::lock_guard<std::mutex> lock(mtx);
+
+	if (state == nSearchState::pending || state == nSearchState::running) { state = nSearchState::cancelled; }
+	abortRunning.store(true);
+	pondering = false;
+	ponderFinished = false;
+	ponderRequest += 1; // (<- the replies explored during the previous game are not continued)
+	resultLine = principalVariation();
+
+	transpositions.startNewGeneration(transpositionTable::keptGenerations);
+	startNewMoveHistoryAge();
+}
+void p4ai::engine::setThreadCount(uint _threadCount)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	threadCount = ff::maxOf(_threadCount, (uint)1);
+}
+void p4ai::engine::setParallelMode(nParallelMode _mode)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	parallelMode = _mode;
+}
+void p4ai::engine::setSolveMode(bool _solve)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	solveMode = _solve;
+}
+void p4ai::engine::setProofNodes(uint64 _proofNodes)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	proofNodes = _proofNodes;
+}
+void p4ai::engine::run()
+{
+	abortSignal = &abortRunning;
+
+	std::unique_lock<std::mutex> lock(mtx);
+	while (!stopWorker.load())
+	{
+		if (state == nSearchState::pending) { runSearch(lock); }
+		else if (pondering) { runPonderStep(lock); }
+		else { wakeUp.wait(lock); }
+	}
+}
+void p4ai::engine::runSearch(std::unique_lock<std::mutex>& _lock)
+{
+	// Take the submitted search:
+	searchHandle handle = lastHandle;
+	bitboard searchBoard = board;
+	uint searchDepth = wantedDepth;
+	abortRunning.store(false);
+	updatePool();
+	searchNodeLimit.store(maxNodes);
+	searchNodesSpent.store(0);
+	timeManager time = timeManager(searchBoard, moveBudgetMs); // (<- the budget starts when the worker takes the search)
+	state = nSearchState::running;
+	startNewMoveHistoryAge(); // (<- a new move of the game: older cutoffs matter less)
+	transpositions.startNewGeneration(); // (<- entries of the moves before the last one become stale)
+
+	// Continue from pondering if the position is one of the explored replies:
+	iterativeSearch start = iterativeSearch(searchBoard, searchDepth);
+	for (uint i = 0; i < 7; i += 1)
+	{
+		if (ponderActive[i] && ponderSearches[i].board == searchBoard && ponderSearches[i].maxDepth == start.maxDepth) { start = ponderSearches[i]; }
+		ponderActive[i] = false;
+	}
+	ponderStarted = ponderRequest;
+
+	// Opening book: positions searched at least as deep as wanted need no search
+	boardEvaluation bookEval;
+	uint neededDepth = solveMode ? searchBoard.getTurnsLeft() : start.maxDepth;
+	if (book.probe(searchBoard, bookEval) && bookEval.relativeDepth >= neededDepth)
+	{
+		result = bookEval;
+		resultLine.setWithContinuation(bookEval.column, principalVariation());
+		state = nSearchState::finished;
+		return;
+	}
+
+	if (solveMode) { runSolve(_lock, handle, searchBoard, time); return; }
+
+	parallelSearch search = parallelSearch(start, threadCount, parallelMode, pool);
+
+	// Search depth after depth in slices until every depth is explored, the time manager decides to play, or the search is replaced / cancelled:
+	bool searching = true;
+	while (searching)
+	{
+		_lock.unlock();
+		uint finishedDepth = search.main.bestDepth;
+		search.step(ff::minOf(sliceMs, time.getRemainingMs()));
+		time.update(search.main.best, search.main.bestDepth);
+		_lock.lock();
+
+		if (stopWorker.load() || handle != lastHandle || state != nSearchState::running) { break; }
+
+		result = search.getBest(); // (<- the last finished depth is always available, even if the budget runs out)
+		resultLine = search.getBestLine();
+		resultStats = search.getStats();
+		bool outOfNodes = maxNodes > 0 && searchNodesSpent.load() >= maxNodes;
+		if (search.isFinished() || outOfNodes || time.shouldStop(search.main.bestDepth > finishedDepth)) { state = nSearchState::finished; searching = false; }
+	}
+}
+void p4ai::engine::runSolve(std::unique_lock<std::mutex>& _lock, searchHandle _handle, bitboard _board, const timeManager& _time)
+{
+	solver solving = solver(_board);
+	solving.pool = pool.get();
+	solving.proofNodes = proofNodes;
+
+	// Null-window searches in slices until the score is proven, the hard limit is reached, or the search is replaced / cancelled (a proof has no depth to stop after: only the hard limit applies)
+	bool searching = true;
+	while (searching)
+	{
+		_lock.unlock();
+		solving.step(ff::minOf(sliceMs, _time.getRemainingMs()));
+		_lock.lock();
+
+		if (stopWorker.load() || _handle != lastHandle || state != nSearchState::running) { break; }
+
+		result = solving.getBest();
+		resultLine = solving.getBestLine();
+		resultStats = solving.stats;
+		bool outOfNodes = maxNodes > 0 && searchNodesSpent.load() >= maxNodes;
+		if (solving.isFinished() || outOfNodes || _time.getRemainingMs() == 0) { state = nSearchState::finished; searching = false; }
+	}
+}
+void p4ai::engine::runPonderStep(std::unique_lock<std::mutex>& _lock)
+{
+	abortRunning.store(false);
+	updatePool();
+	searchNodeLimit.store(0); // (<- pondering has no node budget)
+
+	// Create one search per opponent reply when the pondered board changes:
+	if (ponderStarted != ponderRequest)
+	{
+		ponderStarted = ponderRequest;
+		ponderNext = 0;
+		for (uint i = 0; i < 7; i += 1)
+		{
+			bitboard reply = ponderBoard;
+			ponderActive[i] = reply.canDropColumn(i);
+			if (!ponderActive[i]) { continue; }
+
+			reply.dropColumn(i);
+			ponderActive[i] = reply.getLastMoveStatus() == nBoardStatus::playing;
+			if (ponderActive[i]) { ponderSearches[i] = iterativeSearch(reply, ponderDepth); }
+		}
+
+		// Board reached by the first column of the last search: the reply its line expects is explored first, following the rest of the line
+		bitboard expectedBoard = board;
+		uint8 expectedReply = resultLine[1];
+		if (resultLine.length >= 2 && expectedBoard.canDropColumn(resultLine[0])) { expectedBoard.dropColumn(resultLine[0]); }
+		if (resultLine.length >= 2 && expectedBoard == ponderBoard && ponderActive[expectedReply])
+		{
+			ponderSearches[expectedReply].bestLine = resultLine.getSuffix(2);
+			ponderNext = expectedReply;
+		}
+	}
+
+	// Pick the next replies that still have depths to explore (as many as there are threads):
+	ff::dynarray<uint> columns;
+	for (uint i = 0; i < 7 && columns.size() < threadCount; i += 1)
+	{
+		uint candidate = (ponderNext + i) % 7;
+		if (ponderActive[candidate] && !ponderSearches[candidate].isFinished()) { columns.pushback(candidate); }
+	}
+	if (columns.size() == 0) { pondering = false; ponderFinished = true; return; } // (<- every reply is fully explored)
+	ponderNext = columns.back() + 1;
+
+	// Explore them for one slice, the worker thread and each pool thread explore one reply (the lock is released so that start() and ponder() never wait):
+	ff::dynarray<iterativeSearch> searches;
+	for (uint i = 0; i < columns.size(); i += 1) { searches.pushback(ponderSearches[columns[i]]); }
+	_lock.unlock();
+	std::atomic<uint> pendingReplies;
+	pendingReplies.store(searches.size() - 1);
+	for (uint i = 1; i < searches.size(); i += 1)
+	{
+		pool->push([this, &searches, &pendingReplies, i]()
+			{
+				const std::atomic<bool>* previousAbortSignal = abortSignal;
+				abortSignal = &abortRunning;
+				searches[i].step(sliceMs);
+				abortSignal = previousAbortSignal;
+				pendingReplies.fetch_sub(1); // (<- last access: the worker thread may return as soon as this reaches 0)
+			});
+	}
+	searches[0].step(sliceMs);
+	while (pendingReplies.load() > 0) { if (!pool->runOne()) { std::this_thread::yield(); } }
+	_lock.lock();
+	for (uint i = 0; i < columns.size(); i += 1) { ponderSearches[columns[i]] = searches[i]; }
+}
+void p4ai::engine::updatePool()
+{
+	if (threadCount <= 1) { pool = nullptr; }
+	else if (pool == nullptr || pool->getThreadCount() != threadCount) { pool = std::make_shared<workStealingPool>(threadCount); }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+
+#include "ff/ffsetup.hpp"
+#include "ff/ffbitops.hpp"
+#include "ff/ffmath.hpp"
+
+#include "bitboard.hpp"
+
+namespace p4ai
+{
+	/// \brief Memory of the moves that caused cutoffs, used to explore them early in the next nodes (killer moves and history heuristic)
+	/// \detail Killer moves: per ply (depth from the root of the search), the last two columns that caused a cutoff, likely to cause one again in the brothers of the node
+	/// History: per player and per cell, the sum of the squared remaining depths of the cutoffs caused by dropping on that cell
+	/// Kept per thread (see cutoffMemory), aged between searches so that the previous positions still help without dominating
+	struct moveHistory
+	{
+		static const uint maxPly = bitboard::xSize * bitboard::ySize + 1;
+		static const uint cellCount = bitboard::xSize * bitboard::ySize;
+		static const uint32 maxHistory = 1 << 20; // (<- every entry is halved when one reaches it)
+
+		uint8 killers[maxPly][2];
+		uint32 history[2][cellCount];
+		uint age = 0; // (<- last value of moveHistoryAge the tables were aged for)
+
+		moveHistory();
+
+		/// \brief Remove every killer move and every history entry
+		void clear();
+
+		/// \brief Halve every history entry
+		void halveHistory();
+
+		/// \brief Age the tables for every new age started since the last call (see startNewMoveHistoryAge()): history is halved once per age, killer moves are removed
+		void catchUpAge();
+
+		/// \brief Remember that a column caused a cutoff
+		///
+		/// \param _board: The board of the node where the cutoff happened
+		/// \param _column: The column that caused the cutoff
+		/// \param _ply: Depth of the node from the root of the search
+		/// \param _remainingDepth: How deep the node was explored (deeper cutoffs count more)
+		void addCutoff(const bitboard& _board, uint8 _column, uint _ply, uint _remainingDepth);
+
+		/// \brief Get the rank of a column among the killer moves of a ply [0: not a killer move] [1: older killer move] [2: latest killer move]
+		uint getKillerRank(uint _ply, uint8 _column) const;
+
+		/// \brief Get the history score of dropping in a column, for the player whose turn it is [0, maxHistory[
+		uint32 getHistory(const bitboard& _board, uint8 _column) const;
+
+		/// \brief Get the index of the cell a token dropped in a column lands on [0, cellCount[
+		static uint getDropCellIndex(const bitboard& _board, uint8 _column);
+	};
+
+
+	/// \brief Switch used to compare the search with and without killer moves and history (set it before starting a search)
+	bool useMoveHistory = true;
+
+	/// \brief Cutoff memory of the current thread
+	thread_local moveHistory cutoffMemory;
+
+	/// \brief Incremented for every new search, each thread ages its cutoff memory once per increment the next time it searches
+	std::atomic<uint> moveHistoryAge(0);
+
+	/// \brief Age the cutoff memory of every thread (call it between moves of the game)
+	void startNewMoveHistoryAge();
+}
+
+
+
+p4ai::moveHistory::moveHistory() { clear(); }
+void p4ai::moveHistory::clear()
+{
+	for (uint i = 0; i < maxPly; i += 1) { killers[i][0] = -1; killers[i][1] = -1; }
+	for (uint i = 0; i < cellCount; i += 1) { history[0][i] = 0; history[1][i] = 0; }
+}
+void p4ai::moveHistory::halveHistory()
+{
+	for (uint i = 0; i < cellCount; i += 1) { history[0][i] /= 2; history[1][i] /= 2; }
+}
+void p4ai::moveHistory::catchUpAge()
+{
+	uint currentAge = moveHistoryAge.load(std::memory_order_relaxed);
+	if (age == currentAge) { return; }
+
+	for (uint i = 0; i < currentAge - age && i < 20; i += 1) { halveHistory(); } // (<- 20 halvings empty every entry)
+	for (uint i = 0; i < maxPly; i += 1) { killers[i][0] = -1; killers[i][1] = -1; } // (<- the plies of the new search are not the plies of the previous one)
+	age = currentAge;
+}
+void p4ai::moveHistory::addCutoff(const bitboard& _board, uint8 _column, uint _ply, uint _remainingDepth)
+{
+	if (_ply < maxPly && killers[_ply][1] != _column)
+	{
+		killers[_ply][0] = killers[_ply][1];
+		killers[_ply][1] = _column;
+	}
+
+	uint32& entry = history[(uint)_board.getTurn()][getDropCellIndex(_board, _column)];
+	entry += _remainingDepth * _remainingDepth;
+	if (entry >= maxHistory) { halveHistory(); }
+}
+uint p4ai::moveHistory::getKillerRank(uint _ply, uint8 _column) const
+{
+	if (_ply >= maxPly) { return 0; }
+	if (killers[_ply][1] == _column) { return 2; }
+	if (killers[_ply][0] == _column) { return 1; }
+	return 0;
+}
+uint32 p4ai::moveHistory::getHistory(const bitboard& _board, uint8 _column) const { return history[(uint)_board.getTurn()][getDropCellIndex(_board, _column)]; }
+uint p4ai::moveHistory::getDropCellIndex(const bitboard& _board, uint8 _column)
+{
+	uint height = ff::bitops::countBits(_board.filledCells & ops::getColumnMask(_column));
+	return _column * bitboard::ySize + ff::minOf(height, bitboard::ySize - 1);
+}
+void p4ai::startNewMoveHistoryAge() { moveHistoryAge.fetch_add(1); }
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <unordered_set>
+
+#include "ff/ffmappedfile.hpp"
+#include "ff/fflog.hpp"
+#include "ff/fftime.hpp"
+
+#include "p4ai.hpp"
+
+namespace p4ai
+{
+	/// \brief Precomputed evaluations of the opening positions, read from a memory-mapped file (no search and no warm-up for the first moves)
+	/// \detail File: a header followed by one 64-bit record per position, sorted by canonical key (see bitboard::getCanonicalKey()) so that positions are found by binary search
+	/// Record bits: [63, 15] canonical key (49 bits), [14, 12] best column of the canonical board, [11, 6] score + 32, [5, 0] depth of the search
+	/// Positions without a valid best column are not written, a record whose column is not a column of the board is treated as missing
+	struct openingBook
+	{
+		static const uint32 magic = 0x4B423450; // "P4BK"
+		static const uint32 version = 1;
+
+		struct header
+		{
+			uint32 magic = openingBook::magic;
+			uint32 version = openingBook::version;
+			uint64 recordCount = 0;
+		};
+
+		ff::mappedfile file;
+		const uint64* records = nullptr;
+		uint64 recordCount = 0;
+
+		/// \brief Map a book file (the previous book is unloaded)
+		/// \return [true: if the file is a valid book] [false: otherwise, the book stays empty]
+		bool load(const ff::string& _path);
+		void unload();
+		bool isLoaded() const;
+
+		/// \brief Get the evaluation of a board (or of its mirror) from the book
+		///
+		/// \param _board: The board to look up
+		/// \param _eval: RETURN VALUE of the evaluation, with the column to play on this board (unchanged if the board is not in the book)
+		///
+		/// \return [true: if the board is in the book with a valid column] [false: otherwise]
+		bool probe(const bitboard& _board, boardEvaluation& _eval) const;
+
+		static uint64 pack(uint64 _canonicalKey, const boardEvaluation& _eval);
+		static boardEvaluation unpack(uint64 _record);
+	};
+
+
+	/// \brief Book used by the engine before starting any search (empty until loaded)
+	openingBook book;
+
+
+	/// \brief Search every position reachable in up to _maxPly moves and write them to a book file
+	/// \detail Positions are searched from the deepest ply to the first one, so that the shallow ones reuse the transposition table filled by the deep ones
+	///
+	/// \param _path: The book file to write
+	/// \param _maxPly: Number of moves played in the deepest positions of the book
+	/// \param _searchDepth: Depth of the search of each position (42 or more: positions are solved, their score is exact)
+	/// \param _threadCount: Number of positions searched at the same time [1, ...]
+	///
+	/// \return Number of positions written to the book, positions without a valid best column are skipped (0 if the file could not be written)
+	uint64 generateOpeningBook(const ff::string& _path, uint _maxPly, uint _searchDepth, uint _threadCount);
+}
+
+
+
+bool p4ai::openingBook::load(const ff::string& _path)
+{
+	unload();
+	if (!file.open(_path)) { return false; }
+
+	const header& fileHeader = file.mem.getAtByte<header>(0);
+	bool isValid = file.mem.size >= sizeof(header) && fileHeader.magic == magic && fileHeader.version == version;
+	isValid = isValid && file.mem.size == sizeof(header) + fileHeader.recordCount * sizeof(uint64);
+	if (!isValid) { file.close(); return false; }
+
+	records = &file.mem.getAtByte<uint64>(sizeof(header));
+	recordCount = fileHeader.recordCount;
+	return true;
+}
+void p4ai::openingBook::unload()
+{
+	file.close();
+	records = nullptr;
+	recordCount = 0;
+}
+bool p4ai::openingBook::isLoaded() const { return records != nullptr; }
+bool p4ai::openingBook::probe(const bitboard& _board, boardEvaluation& _eval) const
+{
+	if (records == nullptr) { return false; }
+
+	bool isMirrored = false;
+	uint64 key = _board.getCanonicalKey(isMirrored);
+
+	const uint64* found = std::lower_bound(records, records + recordCount, key << 15);
+	if (found == records + recordCount || (*found >> 15) != key) { return false; }
+
+	boardEvaluation eval = unpack(*found);
+	if (eval.column >= bitboard::xSize) { return false; } // (<- corrupted record: 3 bits can hold a column past the board)
+
+	_eval = eval;
+	if (isMirrored) { _eval.column = (uint8)(bitboard::xSize - 1 - _eval.column); }
+	return true;
+}
+uint64 p4ai::openingBook::pack(uint64 _canonicalKey, const boardEvaluation& _eval)
+{
+	return (_canonicalKey << 15) | ((uint64)(_eval.column & 0x7) << 12) | ((uint64)((_eval.score + 32) & 0x3F) << 6) | (uint64)(_eval.relativeDepth & 0x3F);
+}
+p4ai::boardEvaluation p4ai::openingBook::unpack(uint64 _record)
+{
+	boardEvaluation eval = boardEvaluation(nEvaluation::exhaustive, (int8)((int)((_record >> 6) & 0x3F) - 32), (uint8)(_record & 0x3F));
+	eval.column = (uint8)((_record >> 12) & 0x7);
+	return eval;
+}
+uint64 p4ai::generateOpeningBook(const ff::string& _path, uint _maxPly, uint _searchDepth, uint _threadCount)
+{
+	// List the positions ply by ply, a position and its mirror are listed once:
+	std::vector<std::vector<bitboard>> plies(1, std::vector<bitboard>(1, bitboard()));
+	std::unordered_set<uint64> listed;
+	for (uint ply = 1; ply <= _maxPly; ply += 1)
+	{
+		plies.push_back(std::vector<bitboard>());
+		for (const bitboard& parent : plies[ply - 1])
+		{
+			for (uint x = 0; x < bitboard::xSize; x += 1)
+			{
+				bitboard child = parent;
+				if (!child.canDropColumn(x)) { continue; }
+				child.dropColumn(x);
+				if (child.getLastMoveStatus() != nBoardStatus::playing) { continue; } // (<- nothing to play)
+
+				bool isMirrored = false;
+				if (listed.insert(child.getCanonicalKey(isMirrored)).second) { plies[ply].push_back(child); }
+			}
+		}
+		ff::log() << "Ply " << ply << ": " << (uint64)plies[ply].size() << " positions\n";
+	}
+
+	std::vector<bitboard> positions;
+	for (uint ply = _maxPly + 1; ply > 0; ply -= 1) { positions.insert(positions.end(), plies[ply - 1].begin(), plies[ply - 1].end()); }
+
+	// Search every position (deepest first), on every thread:
+	std::vector<uint64> records(positions.size());
+	std::atomic<uint64> next;
+	std::atomic<uint64> done;
+	next.store(0);
+	done.store(0);
+
+	std::vector<std::thread> threads;
+	for (uint i = 0; i < ff::maxOf(_threadCount, (uint)1); i += 1)
+	{
+		threads.push_back(std::thread([&]()
+			{
+				for (uint64 idx = next.fetch_add(1); idx < positions.size(); idx = next.fetch_add(1))
+				{
+					iterativeSearch search = iterativeSearch(positions[idx], _searchDepth);
+					while (!search.isFinished()) { search.step(-1); }
+
+					boardEvaluation eval = search.getBest();
+					eval.relativeDepth = search.maxDepth;
+					if (eval.column >= bitboard::xSize) { records[idx] = 0; done.fetch_add(1); continue; } // (<- no column to play: skipped, pack() would wrap the column into a valid one)
+
+					bool isMirrored = false;
+					uint64 key = positions[idx].getCanonicalKey(isMirrored);
+					if (isMirrored) { eval.column = (uint8)(bitboard::xSize - 1 - eval.column); } // (<- records hold the column of the canonical board)
+					records[idx] = openingBook::pack(key, eval);
+					done.fetch_add(1);
+				}
+			}));
+	}
+
+	ff::timer progress;
+	while (done.load() < positions.size())
+	{
+		ff::sleep(100);
+		if (progress.tickEveryMilli(10000)) { ff::log() << "Searched " << done.load() << " / " << (uint64)positions.size() << " positions\n"; }
+	}
+	for (uint i = 0; i < threads.size(); i += 1) { threads[i].join(); }
+
+	// Write the sorted records (without the skipped positions):
+	records.erase(std::remove(records.begin(), records.end(), (uint64)0), records.end());
+	std::sort(records.begin(), records.end());
+
+	openingBook::header fileHeader;
+	fileHeader.recordCount = records.size();
+
+	std::ofstream output = std::ofstream(_path.data(), std::ios::out | std::ios::binary);
+	if (!output.is_open()) { return 0; }
+	output.write((const char*)&fileHeader, sizeof(openingBook::header));
+	output.write((const char*)records.data(), records.size() * sizeof(uint64));
+	if (output.fail()) { return 0; }
+
+	return records.size();
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <thread>
+#include <memory>
+
+#include "ff/ffdynarray.hpp"
+
+#include "p4ai.hpp"
+
+namespace p4ai
+{
+	/// \brief How the threads of a parallel search share the work (lazySmp, youngBrothersWait):
+	/// - lazySmp: every thread explores the whole tree at its own depth, threads only share the transposition table
+	/// - youngBrothersWait: threads explore different sub-trees of the same depth, the younger brothers of a node are stolen by idle threads once its eldest brother is explored
+	enum class nParallelMode : char { lazySmp, youngBrothersWait };
+
+	/// \brief Get the name of a parallel mode (for logs)
+	ff::string getParallelModeName(nParallelMode _mode);
+
+	/// \brief Parallel iterative search, in one of the modes of nParallelMode
+	/// \detail Lazy SMP: helper threads explore the same position as the main iterative search, one or two depths ahead of it
+	/// Threads only communicate through the shared transposition table: helpers fill it with deeper results that the main search then reuses
+	/// When a helper finishes a depth before the main search, the main search takes its result and continues from the next depth
+	/// Helpers run as tasks of a work-stealing pool, whose threads live as long as the pool (their thread_local tables carry over from one step to the next)
+	/// Young Brothers Wait: the main search runs on the current thread, and the other threads of a work-stealing pool take part in each of its nodes
+	struct parallelSearch
+	{
+		nParallelMode mode = nParallelMode::lazySmp;
+		iterativeSearch main;
+		ff::dynarray<iterativeSearch> helpers;		// (lazy SMP only)
+		std::shared_ptr<workStealingPool> pool;		// threads running the helpers (lazy SMP) or taking part in each node (young brothers wait), shared by the copies of the search
+
+		parallelSearch() {}
+		parallelSearch(bitboard _board, uint _maxDepth, uint _threadCount, nParallelMode _mode = nParallelMode::lazySmp, std::shared_ptr<workStealingPool> _pool = nullptr);
+
+		/// \param _main: Search to continue (for example a search started while pondering)
+		/// \param _threadCount: Total number of threads, including the main search [1, ...]
+		/// \param _mode: How the threads share the work
+		/// \param _pool: Pool of _threadCount threads to run on, kept alive by its owner between searches (nullptr: the search creates its own pool)
+		parallelSearch(const iterativeSearch& _main, uint _threadCount, nParallelMode _mode = nParallelMode::lazySmp, std::shared_ptr<workStealingPool> _pool = nullptr);
+
+		/// \brief Explore for a given time on every thread, until the main search finishes a depth or times out (helpers are aborted through their abort flag at that point)
+		///
+		/// \param _timeoutMs: How much time the step is given before it times out
+		void step(uint _timeoutMs);
+
+		/// \brief Check if every wanted depth has been explored
+		bool isFinished() const;
+
+		/// \brief Get the best evaluation available right now (the last finished depth, or the partial result if no depth is finished yet)
+		boardEvaluation getBest() const;
+
+		/// \brief Get the line of the best evaluation available right now (see getBest())
+		principalVariation getBestLine() const;
+
+		/// \brief Get the measurements of every thread since the search started (the time is the one of the main search)
+		searchStats getStats() const;
+
+		uint getThreadCount() const;
+	};
+}
+
+
+
+ff::string p4ai::getParallelModeName(nParallelMode _mode) { return (_mode == nParallelMode::lazySmp) ? "lazy SMP" : "young brothers wait"; }
+p4ai::parallelSearch::parallelSearch(bitboard _board, uint _maxDepth, uint _threadCount, nParallelMode _mode, std::shared_ptr<workStealingPool> _pool) : parallelSearch(iterativeSearch(_board, _maxDepth), _threadCount, _mode, _pool) {}
+p4ai::parallelSearch::parallelSearch(const iterativeSearch& _main, uint _threadCount, nParallelMode _mode, std::shared_ptr<workStealingPool> _pool)
+{
+	mode = _mode;
+	main = _main;
+	if (_threadCount > 1) { pool = (_pool != nullptr) ? _pool : std::make_shared<workStealingPool>(_threadCount); }
+	if (mode == nParallelMode::lazySmp) { for (uint i = 1; i < _threadCount; i += 1) { helpers.pushback(iterativeSearch(main.board, main.maxDepth)); } }
+}
+void p4ai::parallelSearch::step(uint _timeoutMs)
+{
+	if (isFinished()) { return; }
+
+	// Young Brothers Wait: the pool takes part in every node of the main search:
+	if (mode == nParallelMode::youngBrothersWait)
+	{
+		main.pool = pool.get();
+		main.step(_timeoutMs);
+		main.pool = nullptr; // (<- the main search can be copied out of this search, it must not keep the pool)
+		return;
+	}
+
+	// Keep helpers ahead of the main search (half of them 1 depth ahead, the other half 2 depths ahead):
+	for (uint i = 0; i < helpers.size(); i += 1)
+	{
+		uint wantedDepth = ff::minOf(main.depth + 1 + (i % 2), main.maxDepth);
+		if (helpers[i].depth < wantedDepth)
+		{
+			helpers[i].depth = wantedDepth;
+			helpers[i].window = fullWindow();
+		}
+	}
+
+	// Explore on every thread (one helper per pool thread), helpers are aborted through their abort flag as soon as the main search returns:
+	std::atomic<bool> mainReturned;
+	mainReturned.store(false);
+	std::atomic<uint> pendingHelpers;
+	pendingHelpers.store(helpers.size());
+	for (uint i = 0; i < helpers.size(); i += 1)
+	{
+		pool->push([this, i, _timeoutMs, &mainReturned, &pendingHelpers]()
+			{
+				const std::atomic<bool>* previousAbortSignal = abortSignal;
+				abortSignal = &mainReturned;
+				if (!mainReturned.load()) { helpers[i].step(_timeoutMs); } // (<- a helper taken back by the main thread once it returned is skipped)
+				abortSignal = previousAbortSignal;
+				pendingHelpers.fetch_sub(1); // (<- last access: the main thread may return as soon as this reaches 0)
+			});
+	}
+	main.step(_timeoutMs);
+	mainReturned.store(true);
+	while (pendingHelpers.load() > 0) { if (!pool->runOne()) { std::this_thread::yield(); } }
+
+	// Take the result of a helper that finished a depth the main search did not reach yet:
+	for (uint i = 0; i < helpers.size(); i += 1)
+	{
+		const iterativeSearch& helper = helpers[i];
+		if (helper.best.type != nEvaluation::exhaustive || helper.bestDepth < main.depth) { continue; }
+
+		main.best = helper.best;
+		main.bestLine = helper.bestLine;
+		main.bestDepth = helper.bestDepth;
+		main.depth = helper.bestDepth + 1;
+		main.window = ff::interval<int>(helper.best.score - iterativeSearch::aspirationDelta, helper.best.score + iterativeSearch::aspirationDelta + 1);
+	}
+}
+bool p4ai::parallelSearch::isFinished() const { return main.isFinished(); }
+p4ai::boardEvaluation p4ai::parallelSearch::getBest() const { return main.getBest(); }
+p4ai::principalVariation p4ai::parallelSearch::getBestLine() const { return main.getBestLine(); }
+p4ai::searchStats p4ai::parallelSearch::getStats() const
+{
+	searchStats result = main.stats;
+	for (uint i = 0; i < helpers.size(); i += 1) { result += helpers[i].stats; }
+	result.timeMs = main.stats.timeMs;
+	return result;
+}
+uint p4ai::parallelSearch::getThreadCount() const { return (mode == nParallelMode::youngBrothersWait && pool != nullptr) ? pool->getThreadCount() : helpers.size() + 1; }
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ff/fflog.hpp"
+
+#include "bitboard.hpp"
+
+namespace p4ai
+{
+	/// \brief Line of columns the search expects to be played from a position (principal variation: each player plays its best column)
+	struct principalVariation
+	{
+		static const uint maxLength = bitboard::xSize * bitboard::ySize;
+
+		uint8 columns[maxLength];
+		uint8 length = 0;
+
+		/// \brief Replace the line by a column followed by the line of the position it leads to
+		///
+		/// \param _column: First column of the line
+		/// \param _continuation: Line expected after the column
+		void setWithContinuation(uint8 _column, const principalVariation& _continuation);
+
+		/// \brief Get the line without its first columns (the line expected once they are played)
+		///
+		/// \param _count: Number of columns to remove
+		principalVariation getSuffix(uint _count) const;
+
+		/// \brief Get a column of the line (-1 past the end of the line)
+		uint8 operator[](uint _idx) const;
+
+		/// \brief Get the string representation of the line
+		///
+		/// \return Columns [1, 7] one after the other, the format of bitboard::playMoves() (for example "4453")
+		ff::string getString() const;
+	};
+
+
+	/// \brief Triangular table of the principal variations of the current thread: pvLines[ply] is the line of the node being explored at that ply
+	/// \detail A node clears its line when it is entered, and rebuilds it from the line of a child whenever that child improves its score: once the search returns, pvLines[0] is the line of the root
+	thread_local principalVariation pvLines[principalVariation::maxLength + 1];
+
+	/// \brief Line found by the previous search of the current thread, its columns are explored first in the nodes it goes through (see getExpectedColumn())
+	thread_local principalVariation expectedLine;
+
+	/// \brief Get the column the expected line plays in a node, if the moves leading to the node from the root follow the expected line
+	///
+	/// \param _board: Board of the node, the moves from the root must be in its history (played with bitboard::play())
+	/// \param _ply: Depth of the node from the root of the search
+	///
+	/// \return The expected column, -1 if the node is not on the expected line
+	uint8 getExpectedColumn(const bitboard& _board, uint _ply);
+}
+
+
+
+void p4ai::principalVariation::setWithContinuation(uint8 _column, const principalVariation& _continuation)
+{
+	columns[0] = _column;
+	length = (uint8)ff::minOf((uint)_continuation.length + 1, maxLength);
+	for (uint i = 1; i < length; i += 1) { columns[i] = _continuation.columns[i - 1]; }
+}
+p4ai::principalVariation p4ai::principalVariation::getSuffix(uint _count) const
+{
+	principalVariation suffix;
+	for (uint i = _count; i < length; i += 1) { suffix.columns[i - _count] = columns[i]; }
+	suffix.length = (_count < length) ? length - _count : 0;
+	return suffix;
+}
+uint8 p4ai::principalVariation::operator[](uint _idx) const { return (_idx < length) ? columns[_idx] : -1; }
+ff::string p4ai::principalVariation::getString() const
+{
+	ff::string result = "";
+	for (uint i = 0; i < length; i += 1) { result += (char)('1' + columns[i]); }
+	return result;
+}
+uint8 p4ai::getExpectedColumn(const bitboard& _board, uint _ply)
+{
+	if (_ply >= expectedLine.length || _ply > _board.historySize) { return -1; }
+
+	// Moves from the root, latest first (the latest one is the most likely to differ):
+	for (uint i = _ply; i > 0; i -= 1)
+	{
+		if (_board.history[_board.historySize - _ply + i - 1] != expectedLine.columns[i - 1]) { return -1; }
+	}
+	return expectedLine.columns[_ply];
+}
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <vector>
+
+#include "ff/fftime.hpp"
+#include "ff/ffbitops.hpp"
+
+#include "p4ai.hpp"
+
+namespace p4ai
+{
+	/// \brief Result of a proof-number search (unknown, proven, disproven):
+	/// - unknown: the search ran out of nodes or time before finding the result
+	/// - proven: the player to move reaches the goal of the search whatever the opponent plays
+	/// - disproven: the opponent can always prevent it
+	enum class nProof : char { unknown, proven, disproven };
+
+	/// \brief Table of the proof and disproof numbers of the positions explored by the proof-number searches
+	/// \detail One entry per index, always replaced by the latest position (entries are cheap to rebuild: a missing child is only re-evaluated)
+	/// Not thread-safe: each thread has its own table (see proofNumbers)
+	/// Each key also tells whether draws count as wins for the player to move, so the entries of a search stay valid for every later search
+	struct proofNumberTable
+	{
+		/// \brief Size used by the table of the searches until it is resized
+		static const uint defaultSizeMb = 16;
+
+		struct entry
+		{
+			uint64 key = 0;		// (canonical key << 1) | (draws count as wins for the player to move), 0 if the entry is empty
+			uint32 phi = 0;		// proof number of the player to move: how many positions have to be proven at least before the player to move is proven to reach the goal
+			uint32 delta = 0;	// disproof number of the player to move: same, to prove that it can not
+		};
+
+		std::vector<entry> entries;
+		uint indexShift = 64;
+
+		/// \param _sizeMb: Memory used by the table in megabytes, rounded down to a power of two number of entries [1, ...]
+		proofNumberTable(uint _sizeMb);
+
+		/// \brief Change the memory used by the table, every entry is removed
+		void resize(uint _sizeMb);
+
+		/// \brief Remove every entry
+		void clear();
+
+		/// \brief Get the numbers stored for a key
+		///
+		/// \param _phi: RETURN VALUE of the proof number, unchanged if the key is missing
+		/// \param _delta: RETURN VALUE of the disproof number, unchanged if the key is missing
+		///
+		/// \return [true: if the key was found] [false: otherwise]
+		bool probe(uint64 _key, uint32& _phi, uint32& _delta) const;
+
+		void store(uint64 _key, uint32 _phi, uint32 _delta);
+
+		uint64 getIndex(uint64 _key) const;
+	};
+
+	/// \brief Table of the proof-number searches of the current thread (see proofNumberSearch), allocated the first time the thread uses it
+	/// \detail Searches on other threads (another solve, a benchmark, a batch analysis) never share the entries of a running search
+	thread_local proofNumberTable proofNumbers = proofNumberTable(proofNumberTable::defaultSizeMb);
+
+
+	/// \brief Depth-first proof-number search (df-pn): proves or disproves that the player to move wins, without the exact score
+	/// \detail Best-first in disguise: each position keeps a proof number (phi) and a disproof number (delta) for its player to move, the search always expands the child that is the cheapest to decide, within thresholds that send it back to the parent once another child becomes cheaper
+	/// Positions where the player to move wins right away (ops::getPlaceableWinPositions()) or loses whatever the move (bitboard::possibleNonLosingMoves()) are decided without being expanded, and only the non-losing moves are children: forced sequences of threats cost one node per move
+	/// A new position starts with phi = 1 and delta = number of non-losing moves (a forced move is as cheap to disprove as to prove), between children with the same numbers the one whose move gives the most threats is expanded first
+	/// Very effective on positions decided by threats, poor on drawn positions (every line has to be refuted): give it a node budget, and leave the positions it does not decide to the negamax search (see solver::proofNodes)
+	struct proofNumberSearch
+	{
+		/// \brief Proof and disproof numbers of a decided position (saturated: the numbers of a position never exceed it)
+		static const uint32 infinity = 1 << 30;
+
+		bitboard board;
+		bool drawIsWin = false;			// goal of the player to move: [false: win] [true: win or draw (not lose)]
+		uint64 maxNodes = -1;			// node budget of the search, summed over every step (the result stays unknown once it is spent)
+
+		nProof result = nProof::unknown;
+		uint8 column = -1;				// column that reaches the goal, once the search is proven (-1 otherwise)
+		searchStats stats;				// nodes: positions evaluated, interiorNodes: positions expanded
+		bool aborted = false;			// the last step ran out of time or nodes
+		uint64 nodeLimit = 0;			// thread node count at which the current step has spent the node budget
+
+		proofNumberSearch() {}
+		proofNumberSearch(bitboard _board, bool _drawIsWin, uint64 _maxNodes = -1);
+
+		/// \brief Continue the search, the numbers of the explored positions are kept in proofNumbers: a search can run over several steps
+		///
+		/// \param _timeoutMs: How much time the step is given before it times out
+		void step(uint _timeoutMs);
+
+		/// \brief Check if the search proved or disproved its goal, or spent its node budget
+		bool isFinished() const;
+
+		/// \brief Get the key of a position in proofNumbers (see proofNumberTable::entry::key)
+		uint64 getKey(const bitboard& _board) const;
+
+		/// \brief Get the numbers of a position, without expanding it: decided positions, stored numbers, or the numbers of a new position
+		///
+		/// \param _board: The position, whose game is not over
+		/// \param _phi: RETURN VALUE of the proof number
+		/// \param _delta: RETURN VALUE of the disproof number
+		void evaluate(const bitboard& _board, uint32& _phi, uint32& _delta);
+
+		/// \brief Expand a position until its proof number reaches _thPhi or its disproof number reaches _thDelta (Multiple Iterative Deepening)
+		///
+		/// \param _board: Board of the position, in place: moves are played and undone on it (unchanged when the function returns)
+		/// \param _thPhi: Proof number threshold
+		/// \param _thDelta: Disproof number threshold
+		/// \param _phi: Proof number of the position, updated
+		/// \param _delta: Disproof number of the position, updated
+		/// \param _depth: Depth of the position from the root of the search
+		/// \param _timeoutMs: How much time the step has until timeout is reached
+		/// \param _timer: Timer used for timeout
+		///
+		/// \return The column of the cheapest child to prove (the column that reaches the goal once _phi is 0)
+		uint8 expand(bitboard& _board, uint32 _thPhi, uint32 _thDelta, uint32& _phi, uint32& _delta, uint _depth, uint _timeoutMs, const ff::timer& _timer);
+	};
+
+
+	/// \brief Prove or disprove that the player to move wins (see proofNumberSearch)
+	///
+	/// \param _board: The position, whose game is not over
+	/// \param _maxNodes: Node budget
+	/// \param _column: RETURN VALUE of a winning column if the win is proven, unchanged otherwise
+	nProof proveWin(bitboard _board, uint64 _maxNodes, uint8& _column);
+}
+
+
+
+p4ai::proofNumberTable::proofNumberTable(uint _sizeMb) { resize(_sizeMb); }
+void p4ai::proofNumberTable::resize(uint _sizeMb)
+{
+	uint64 wantedEntries = ff::maxOf((uint64)_sizeMb, (uint64)1) * 1024 * 1024 / sizeof(entry);
+	uint sizeLog2 = 0;
+	while (((uint64)2 << sizeLog2) <= wantedEntries) { sizeLog2 += 1; }
+
+	entries = std::vector<entry>((size_t)1 << sizeLog2);
+	indexShift = 64 - sizeLog2;
+}
+void p4ai::proofNumberTable::clear() { for (uint64 i = 0; i < entries.size(); i += 1) { entries[i] = entry(); } }
+bool p4ai::proofNumberTable::probe(uint64 _key, uint32& _phi, uint32& _delta) const
+{
+	const entry& stored = entries[getIndex(_key)];
+	if (stored.key != _key) { return false; }
+	_phi = stored.phi;
+	_delta = stored.delta;
+	return true;
+}
+void p4ai::proofNumberTable::store(uint64 _key, uint32 _phi, uint32 _delta)
+{
+	entry& stored = entries[getIndex(_key)];
+	stored.key = _key;
+	stored.phi = _phi;
+	stored.delta = _delta;
+}
+uint64 p4ai::proofNumberTable::getIndex(uint64 _key) const { return (_key * 0x9E3779B97F4A7C15ull) >> indexShift; }
+p4ai::proofNumberSearch::proofNumberSearch(bitboard _board, bool _drawIsWin, uint64 _maxNodes)
+{
+	board = _board;
+	drawIsWin = _drawIsWin;
+	maxNodes = _maxNodes;
+}
+void p4ai::proofNumberSearch::step(uint _timeoutMs)
+{
+	if (isFinished()) { return; }
+
+	ff::timer timer;
+	threadStats.maxPly = 0;
+	searchStats statsStart = getThreadStats();
+	aborted = false;
+	nodeLimit = threadStats.nodes + (maxNodes - ff::minOf(stats.nodes, maxNodes));
+
+	uint32 phi = 0;
+	uint32 delta = 0;
+	evaluate(board, phi, delta);
+	uint64 wins = ops::getPlaceableWinPositions(board.filledCells, board.getCurrentPlayerCells());
+	if (wins != 0) { for (uint x = 0; x < bitboard::xSize && column == (uint8)-1; x += 1) { if ((wins & ops::getColumnMask(x)) != 0) { column = x; } } }
+	else if (delta != 0)
+	{
+		bitboard root = board; // (<- played on in place: board has to stay the root, see getKey())
+		column = expand(root, infinity, infinity, phi, delta, 0, _timeoutMs, timer); // (<- also expanded if it was proven by an earlier search: its stored children give the column)
+	}
+
+	if (phi == 0) { result = nProof::proven; }
+	else if (delta == 0) { result = nProof::disproven; column = -1; }
+	else { column = -1; }
+
+	stats += getThreadStats() - statsStart;
+	stats.timeMs += timer.getMilli();
+}
+bool p4ai::proofNumberSearch::isFinished() const { return result != nProof::unknown || stats.nodes >= maxNodes; }
+uint64 p4ai::proofNumberSearch::getKey(const bitboard& _board) const
+{
+	bool isMirrored = false;
+	bool isAttacker = ((_board.getTurnsPlayed() - board.getTurnsPlayed()) % 2) == 0;
+	return (_board.getCanonicalKey(isMirrored) << 1) | (uint64)(isAttacker == drawIsWin); // (<- a draw is the goal of the defender when it is not the one of the attacker)
+}
+void p4ai::proofNumberSearch::evaluate(const bitboard& _board, uint32& _phi, uint32& _delta)
+{
+	threadStats.nodes += 1;
+
+	// Decided positions (immediate win, draw, or loss whatever the move):
+	if (ops::getPlaceableWinPositions(_board.filledCells, _board.getCurrentPlayerCells()) != 0) { _phi = 0; _delta = infinity; return; }
+	uint64 key = getKey(_board);
+	if (_board.getTurnsLeft() == 0)
+	{
+		bool drawWins = (key & 1) != 0;
+		_phi = drawWins ? 0 : infinity;
+		_delta = drawWins ? infinity : 0;
+		return;
+	}
+	uint64 moves = _board.possibleNonLosingMoves();
+	if (moves == 0) { _phi = infinity; _delta = 0; return; }
+
+	// Explored, or new position:
+	if (proofNumbers.probe(key, _phi, _delta)) { return; }
+	_phi = 1;
+	_delta = ff::bitops::countBits(moves);
+}
+uint8 p4ai::proofNumberSearch::expand(bitboard& _board, uint32 _thPhi, uint32 _thDelta, uint32& _phi, uint32& _delta, uint _depth, uint _timeoutMs, const ff::timer& _timer)
+{
+	if (_depth > threadStats.maxPly) { threadStats.maxPly = _depth; }
+
+	// Timeout & node budget:
+	if ((abortSignal != nullptr && abortSignal->load(std::memory_order_relaxed)) || timeoutPoll.isTimedOut(_timer, _timeoutMs) || threadStats.nodes >= nodeLimit) { aborted = true; return -1; }
+	threadStats.interiorNodes += 1;
+
+	// Children (the position is not decided: it has non-losing moves, and none of them wins right away), by the number of threats their move gives, so that ties go to the most threatening move:
+	uint64 moves = _board.possibleNonLosingMoves();
+	columnOrder columns;
+	uint8 colOrder[7] = { 3, 2, 4, 1, 5, 0, 6 };
+	for (uint i = 0; i < 7; i += 1) { if ((moves & ops::getColumnMask(colOrder[i])) != 0) { columns.addColumn(colOrder[i], (int)_board.getColumnThreats(colOrder[i])); } }
+
+	uint32 phis[7];
+	uint32 deltas[7];
+	uint count = columns.size();
+	for (uint i = 0; i < count; i += 1)
+	{
+		_board.play(columns[i]);
+		evaluate(_board, phis[i], deltas[i]);
+		_board.undo();
+	}
+
+	// Expand the cheapest child to disprove for the opponent until the numbers of the position reach a threshold:
+	uint8 best = -1;
+	while (true)
+	{
+		// The player to move needs one child where the opponent fails (phi: smallest delta of the children), and fails only if the opponent reaches its goal in every child (delta: their largest phi, plus a quarter of the others)
+		// A plain sum of the children would count the positions they share several times: transpositions are everywhere in the game, the sum made the search 2 to 3 times slower
+		uint bestIndex = 0;
+		uint32 secondDelta = infinity;
+		uint64 phiSum = 0;
+		uint32 phiMax = 0;
+		for (uint i = 0; i < count; i += 1)
+		{
+			phiSum += phis[i];
+			phiMax = ff::maxOf(phiMax, phis[i]);
+			if (i == bestIndex) { continue; }
+			if (deltas[i] < deltas[bestIndex]) { secondDelta = deltas[bestIndex]; bestIndex = i; }
+			else if (deltas[i] < secondDelta) { secondDelta = deltas[i]; }
+		}
+		_phi = deltas[bestIndex];
+		_delta = (phiMax >= infinity) ? infinity : (uint32)ff::minOf(phiMax + (phiSum - phiMax) / 4, (uint64)infinity);
+		best = columns[bestIndex];
+		if (_phi >= _thPhi || _delta >= _thDelta || aborted) { break; }
+
+		// Thresholds of the child: come back once it is no longer the cheapest (a quarter more than the second one, to avoid going back and forth between two close children), or once the numbers of the position would reach a threshold
+		uint32 childThPhi = (uint32)ff::minOf((uint64)_thDelta - _delta + phis[bestIndex], (uint64)infinity);
+		uint32 childThDelta = (uint32)ff::minOf((uint64)_thPhi, (uint64)secondDelta + secondDelta / 4 + 1);
+		_board.play(columns[bestIndex]);
+		expand(_board, childThPhi, childThDelta, phis[bestIndex], deltas[bestIndex], _depth + 1, _timeoutMs, _timer);
+		_board.undo();
+	}
+
+	proofNumbers.store(getKey(_board), _phi, _delta); // (<- also when aborted: the numbers of a partly expanded position are still valid estimates)
+	return best;
+}
+p4ai::nProof p4ai::proveWin(bitboard _board, uint64 _maxNodes, uint8& _column)
+{
+	proofNumberSearch search = proofNumberSearch(_board, false, _maxNodes);
+	while (!search.isFinished()) { search.step(-1); }
+	if (search.result == nProof::proven) { _column = search.column; }
+	return search.result;
+}
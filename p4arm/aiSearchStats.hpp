@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cmath>
+
+#include "ff/fflog.hpp"
+
+#include "aiTranspositionTable.hpp"
+
+namespace p4ai
+{
+	/// \brief Measurements of a search, filled by every search (see iterativeSearch::stats, parallelSearch::getStats(), solver::stats, engine::poll())
+	/// \detail Counting costs a few increments per position: it is always on
+	struct searchStats
+	{
+		uint64 nodes = 0;				// positions explored
+		uint64 interiorNodes = 0;		// positions whose children were explored (the others are leaves: end of the game, depth limit, immediate win or loss, pruning, stored results)
+		uint64 cutoffs = 0;				// interior positions where a child caused a cutoff
+		uint64 firstMoveCutoffs = 0;	// cutoffs caused by the first explored child (the better the move ordering, the closer to cutoffs)
+		uint maxPly = 0;				// deepest position explored, from the root of the search
+		transpositionTable::counters table;
+		uint depth = 0;					// deepest depth finished by the search (0 if none)
+		uint timeMs = 0;
+
+		uint64 getLeafNodes() const;
+
+		/// \brief Get the percentage of transposition table probes that found their position [0, 100]
+		float getTableHitRate() const;
+
+		/// \brief Get the percentage of cutoffs caused by the first explored child [0, 100]
+		float getFirstMoveCutoffRate() const;
+
+		/// \brief Get the effective branching factor: the number of children each position would have for a tree of that many nodes at the finished depth
+		float getBranchingFactor() const;
+
+		uint64 getNodesPerSecond() const;
+
+		/// \brief Get the string representation of the measurements (for logs)
+		ff::string getString() const;
+
+		/// \brief Get the counters of the positions explored between two snapshots (maxPly and depth are the ones of this snapshot, timeMs is not counted)
+		searchStats operator-(const searchStats& _other) const;
+
+		/// \brief Add the counters of another search (maxPly and depth are the maximum of both, the searches are expected to run at the same time: timeMs is not added)
+		searchStats& operator+=(const searchStats& _other);
+	};
+
+
+	/// \brief Counters of the searches run by the current thread (see getThreadStats(), table counters are kept in transpositionCounters)
+	/// \detail maxPly is reset by each measured step of a search
+	thread_local searchStats threadStats;
+
+	/// \brief Get a snapshot of the counters of the current thread, including its transposition table counters
+	searchStats getThreadStats();
+}
+
+
+
+uint64 p4ai::searchStats::getLeafNodes() const { return nodes - interiorNodes; }
+float p4ai::searchStats::getTableHitRate() const { return (float)table.hits * 100.0f / (float)ff::maxOf(table.probes, (uint64)1); }
+float p4ai::searchStats::getFirstMoveCutoffRate() const { return (float)firstMoveCutoffs * 100.0f / (float)ff::maxOf(cutoffs, (uint64)1); }
+float p4ai::searchStats::getBranchingFactor() const { return (depth > 0) ? std::pow((float)nodes, 1.0f / (float)depth) : 0.0f; }
+uint64 p4ai::searchStats::getNodesPerSecond() const { return nodes * 1000 / ff::maxOf(timeMs, (uint)1); }
+ff::string p4ai::searchStats::getString() const
+{
+	ff::string result = "depth " + (ff::string)depth + " (max ply " + (ff::string)maxPly + "), ";
+	result += (ff::string)nodes + " nodes (" + (ff::string)getLeafNodes() + " leaves), " + (ff::string)timeMs + " ms, " + (ff::string)getNodesPerSecond() + " nodes/s, ";
+	result += "table hits " + (ff::string)(uint)getTableHitRate() + "% (" + (ff::string)table.stores + " stores, " + (ff::string)table.overwrites + " overwrites), ";
+	uint branchingFactor = (uint)(getBranchingFactor() * 100.0f + 0.5f); // (<- in hundredths)
+	result += "first move cutoffs " + (ff::string)(uint)getFirstMoveCutoffRate() + "%, branching factor " + (ff::string)(branchingFactor / 100) + "." + ((branchingFactor % 100 < 10) ? "0" : "") + (ff::string)(branchingFactor % 100);
+	return result;
+}
+p4ai::searchStats p4ai::searchStats::operator-(const searchStats& _other) const
+{
+	searchStats result = *this;
+	result.nodes -= _other.nodes;
+	result.interiorNodes -= _other.interiorNodes;
+	result.cutoffs -= _other.cutoffs;
+	result.firstMoveCutoffs -= _other.firstMoveCutoffs;
+	result.table = table - _other.table;
+	return result;
+}
+p4ai::searchStats& p4ai::searchStats::operator+=(const searchStats& _other)
+{
+	nodes += _other.nodes;
+	interiorNodes += _other.interiorNodes;
+	cutoffs += _other.cutoffs;
+	firstMoveCutoffs += _other.firstMoveCutoffs;
+	maxPly = ff::maxOf(maxPly, _other.maxPly);
+	table += _other.table;
+	depth = ff::maxOf(depth, _other.depth);
+	return *this;
+}
+p4ai::searchStats p4ai::getThreadStats()
+{
+	searchStats result = threadStats;
+	result.table = transpositionCounters;
+	return result;
+}
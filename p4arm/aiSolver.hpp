@@ -0,0 +1,157 @@
+#pragma once
+
+#include "p4ai.hpp"
+#include "aiProofNumber.hpp"
+
+namespace p4ai
+{
+	/// \brief Strong solver: finds the exact score of a position (win, draw or loss, and in how many moves) by exploring until the end of the game
+	/// \detail The score is known to be in [minScore, maxScore], each null-window search tells if it is above a tested score and narrows the range
+	/// Tested scores bisect the range, closer to 0 first (most positions are decided by a few moves, and null-window searches of big scores are fast)
+	/// Null-window searches prune much more than a full window search, and each one reuses the bounds stored in the transposition table by the previous ones
+	/// With a proof-number budget (proofNodes), the first steps prove or disprove a win, then a draw, with proof-number searches: positions decided by threats are narrowed in a few nodes, the null-window searches take over the rest (drawn-looking positions spend the budget without a result)
+	struct solver
+	{
+		/// \brief Proof-number budget of the benchmarks, and of the engine once enabled (see engine::setProofNodes()), in nodes per proof-number search (a few tens of milliseconds)
+		static const uint64 defaultProofNodes = 300000;
+
+		bitboard board;
+		int minScore = 0;				// the exact score is at least this score (proven)
+		int maxScore = 0;				// the exact score is at most this score (proven)
+		workStealingPool* pool = nullptr;	// threads sharing the exploration of each null-window search (nullptr: explore on the current thread only)
+		uint64 proofNodes = 0;			// node budget of each proof-number search run before the null-window searches (0: none, set it before the first step)
+		proofNumberSearch proof;		// current proof-number search: does the player to move win, then (disproven) does it at least draw
+		bool proofDone = false;			// the proof-number searches are over (decided, or out of budget)
+
+		boardEvaluation best;			// result of the last search above its tested score: its column reaches at least minScore (aborted if there is none yet)
+		principalVariation bestLine;	// line of best, followed first by the next searches
+		boardEvaluation current;		// result of the last step (can be partial)
+		principalVariation currentLine;	// line of the last step
+		uint searchCount = 0;			// number of finished null-window searches
+		searchStats stats;				// measurements of every step, including the threads of the pool
+
+		solver() {}
+		solver(bitboard _board);
+
+		/// \brief Continue the current proof-number search or null-window search, narrows the score range once it is finished
+		/// \detail Progress is stored in the tables (proofNumbers, transposition table), so a search can be explored over several steps
+		///
+		/// \param _timeoutMs: How much time the step is given before it times out
+		void step(uint _timeoutMs);
+
+		/// \brief Check if the exact score is proven
+		bool isFinished() const;
+
+		/// \brief Continue the current proof-number search, narrows the score range once it is finished (see step())
+		void stepProof(uint _timeoutMs);
+
+		/// \brief Get the score tested by the next null-window search (is the exact score above it?)
+		int getTestedScore() const;
+
+		/// \brief Get the best evaluation available right now (its score is the proven minimum until the solver is finished)
+		boardEvaluation getBest() const;
+
+		/// \brief Get the line of the best evaluation available right now (see getBest())
+		principalVariation getBestLine() const;
+	};
+
+
+	/// \brief Find the exact score of a position and the column that reaches it (explores until the end of the game, can take very long early in the game)
+	///
+	/// \param _board: The position to solve
+	/// \param _pool: Threads sharing the exploration (nullptr: explore on the current thread only)
+	///
+	/// \return The exact evaluation, with a column to play if the game is not over
+	boardEvaluation solve(bitboard _board, workStealingPool* _pool = nullptr);
+}
+
+
+
+p4ai::solver::solver(bitboard _board)
+{
+	board = _board;
+	best = boardEvaluation(nEvaluation::aborted);
+	current = boardEvaluation(nEvaluation::aborted);
+
+	if (_board.getLastMoveStatus() != nBoardStatus::playing) { minScore = _board.getScore(); maxScore = minScore; return; }
+	minScore = -((int)_board.getTurnsLeft() / 2);		// (<- losing to the next move of the opponent)
+	maxScore = ((int)_board.getTurnsLeft() + 1) / 2;	// (<- winning with the next move)
+	proof = proofNumberSearch(_board, false);
+}
+void p4ai::solver::step(uint _timeoutMs)
+{
+	if (isFinished()) { return; }
+	if (proofNodes > 0 && !proofDone) { stepProof(_timeoutMs); return; }
+
+	ff::timer timer;
+	threadStats.maxPly = 0;
+	searchStats statsStart = getThreadStats();
+	searchStats workerStatsStart = (pool != nullptr) ? pool->getWorkerStats() : searchStats();
+
+	int tested = getTestedScore();
+	current = getPositionScoreNegamaxStart(board, board.getTurnsLeft(), _timeoutMs, ff::interval<int>(tested, tested + 2), bestLine, pool, &currentLine); // (<- window [tested, tested + 1])
+
+	stats += getThreadStats() - statsStart;
+	if (pool != nullptr) { stats += pool->getWorkerStats() - workerStatsStart; }
+	stats.timeMs += timer.getMilli();
+	if (current.type != nEvaluation::exhaustive) { return; }
+	searchCount += 1;
+	stats.depth = board.getTurnsLeft();
+
+	if (current.score <= tested) { maxScore = ff::minOf(maxScore, (int)current.score); } // (<- no move scores above the tested score)
+	else
+	{
+		minScore = ff::maxOf(minScore, (int)current.score); // (<- this move scores at least its score)
+		best = current;
+		bestLine = currentLine;
+	}
+}
+bool p4ai::solver::isFinished() const { return minScore >= maxScore; }
+void p4ai::solver::stepProof(uint _timeoutMs)
+{
+	searchStats proofStatsStart = proof.stats;
+	proof.maxNodes = proofNodes;
+	proof.step(_timeoutMs);
+	stats += proof.stats - proofStatsStart;
+	stats.timeMs += proof.stats.timeMs - proofStatsStart.timeMs;
+	if (!proof.isFinished()) { return; }
+
+	proofDone = true; // (<- out of budget: drawn-looking, or too deep for the budget, the null-window searches take over)
+	if (proof.result == nProof::proven)
+	{
+		minScore = ff::maxOf(minScore, proof.drawIsWin ? 0 : 1);
+		best = boardEvaluation(nEvaluation::exhaustive, (int8)minScore, (uint8)board.getTurnsLeft());
+		best.column = proof.column;
+		bestLine.length = 1;
+		bestLine.columns[0] = proof.column;
+	}
+	else if (proof.result == nProof::disproven)
+	{
+		maxScore = ff::minOf(maxScore, proof.drawIsWin ? -1 : 0);
+		if (!proof.drawIsWin && !isFinished()) { proof = proofNumberSearch(board, true); proofDone = false; } // (<- no win: is it at least a draw?)
+	}
+	if (isFinished()) { stats.depth = board.getTurnsLeft(); }
+}
+int p4ai::solver::getTestedScore() const
+{
+	int tested = minScore + (maxScore - minScore) / 2;
+	if (tested <= 0 && minScore / 2 < tested) { tested = minScore / 2; }
+	else if (tested >= 0 && maxScore / 2 > tested) { tested = maxScore / 2; }
+	return tested;
+}
+p4ai::boardEvaluation p4ai::solver::getBest() const
+{
+	boardEvaluation eval = (best.type == nEvaluation::exhaustive) ? best : current; // (<- without a search above its tested score, every column reaches minScore)
+	eval.score = (int8)minScore;
+	eval.type = isFinished() ? nEvaluation::exhaustive : nEvaluation::aborted;
+	eval.relativeDepth = (uint8)board.getTurnsLeft();
+	return eval;
+}
+p4ai::principalVariation p4ai::solver::getBestLine() const { return (best.type == nEvaluation::exhaustive) ? bestLine : currentLine; }
+p4ai::boardEvaluation p4ai::solve(bitboard _board, workStealingPool* _pool)
+{
+	solver solving = solver(_board);
+	solving.pool = _pool;
+	while (!solving.isFinished()) { solving.step(-1); }
+	return solving.getBest();
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "ff/fflog.hpp"
+
+#include "aiTranspositionTable.hpp"
+#include "aiOpeningBook.hpp"
+
+namespace p4ai
+{
+	/// \brief Snapshot of the exact entries of a transposition table, saved to a file so that a restarted program starts with the results of its previous runs (warm start)
+	/// \detail File: a header followed by one 64-bit record per entry, in the format of the opening book records (see openingBook::pack())
+	/// A loaded file is checked before any entry is stored: header (magic, version, record count, checksum of the records), then every record (key of a reachable position, score, depth and column possible in it)
+	struct tableSnapshot
+	{
+		static const uint32 magic = 0x54543450; // "P4TT"
+		static const uint32 version = 1;
+
+		struct header
+		{
+			uint32 magic = tableSnapshot::magic;
+			uint32 version = tableSnapshot::version;
+			uint64 recordCount = 0;
+			uint64 checksum = 0;
+		};
+
+		/// \brief Get the checksum of records (order dependent)
+		static uint64 getChecksum(const uint64* _records, uint64 _count);
+
+		/// \brief Check that a record describes a position that can be reached, with a score, depth and column possible in that position
+		static bool isValidRecord(uint64 _record);
+	};
+
+
+	/// \brief Save the exact entries of a table to a snapshot file
+	/// \detail Can be called while searches are running: slots torn by a concurrent store are not saved
+	/// The file is written to <_path>.tmp first, then renamed over _path: a save interrupted by a crash or a power cut leaves the previous snapshot intact
+	///
+	/// \return Number of entries written, 0 if the file could not be written
+	uint64 saveTableSnapshot(const transpositionTable& _table, const ff::string& _path);
+
+	/// \brief Store the entries of a snapshot file in a table (added to the entries already in it, with the usual replacement rules)
+	///
+	/// \return Number of entries stored, 0 if the file is missing or invalid (the table is then unchanged)
+	uint64 loadTableSnapshot(transpositionTable& _table, const ff::string& _path);
+}
+
+
+
+uint64 p4ai::tableSnapshot::getChecksum(const uint64* _records, uint64 _count)
+{
+	uint64 checksum = 0xCBF29CE484222325ull;
+	for (uint64 i = 0; i < _count; i += 1) { checksum = (checksum ^ _records[i]) * 0x100000001B3ull; }
+	return checksum;
+}
+bool p4ai::tableSnapshot::isValidRecord(uint64 _record)
+{
+	// Key: each column holds the cells of the player to move under a marker bit, one above the top of the column (see bitboard::getKey())
+	uint64 key = _record >> 15;
+	uint turnsPlayed = 0;
+	uint currentPlayerCells = 0;
+	uint64 height[bitboard::xSize];
+	for (uint x = 0; x < bitboard::xSize; x += 1)
+	{
+		uint64 column = (key >> (x * (bitboard::ySize + 1))) & ((1 << (bitboard::ySize + 1)) - 1);
+		if (column == 0) { return false; }
+
+		height[x] = 0;
+		while ((column >> (height[x] + 1)) != 0) { height[x] += 1; }
+		turnsPlayed += (uint)height[x];
+		for (uint64 y = 0; y < height[x]; y += 1) { currentPlayerCells += (uint)((column >> y) & 1); }
+	}
+	if ((key >> (bitboard::xSize * (bitboard::ySize + 1))) != 0) { return false; }
+	if (currentPlayerCells != turnsPlayed / 2) { return false; } // (<- the player to move played as many moves as the other one, or one less)
+
+	// Evaluation:
+	boardEvaluation eval = openingBook::unpack(_record);
+	int turnsLeft = (int)(bitboard::xSize * bitboard::ySize) - (int)turnsPlayed;
+	if (eval.score < -(turnsLeft / 2) || eval.score > (turnsLeft + 1) / 2) { return false; }
+	if (eval.relativeDepth > turnsLeft) { return false; }
+	return eval.column < bitboard::xSize && height[eval.column] < bitboard::ySize;
+}
+uint64 p4ai::saveTableSnapshot(const transpositionTable& _table, const ff::string& _path)
+{
+	std::vector<uint64> records;
+	for (uint64 i = 0; i < _table.buckets.size(); i += 1)
+	{
+		const transpositionTable::slot* slots[2] = { &_table.buckets[i].deepest, &_table.buckets[i].latest };
+		for (uint j = 0; j < 2; j += 1)
+		{
+			uint64 data = slots[j]->data.load(std::memory_order_relaxed);
+			uint64 key = slots[j]->check.load(std::memory_order_relaxed) ^ data;
+			if (data == 0 || _table.getIndex(key) != i || transpositionTable::unpackBound(data) != nBound::exact) { continue; }
+
+			uint64 record = openingBook::pack(key, transpositionTable::unpack(data));
+			if (tableSnapshot::isValidRecord(record)) { records.push_back(record); }
+		}
+	}
+
+	tableSnapshot::header fileHeader;
+	fileHeader.recordCount = records.size();
+	fileHeader.checksum = tableSnapshot::getChecksum(records.data(), records.size());
+
+	ff::string tmpPath = _path + ".tmp";
+	std::ofstream output = std::ofstream(tmpPath.data(), std::ios::out | std::ios::binary);
+	if (!output.is_open()) { return 0; }
+	output.write((const char*)&fileHeader, sizeof(tableSnapshot::header));
+	output.write((const char*)records.data(), records.size() * sizeof(uint64));
+	output.close();
+	if (output.fail()) { std::remove(tmpPath.data()); return 0; }
+
+	if (std::rename(tmpPath.data(), _path.data()) != 0)
+	{
+		std::remove(_path.data()); // (<- rename does not replace an existing file on Windows)
+		if (std::rename(tmpPath.data(), _path.data()) != 0) { std::remove(tmpPath.data()); return 0; }
+	}
+	return records.size();
+}
+uint64 p4ai::loadTableSnapshot(transpositionTable& _table, const ff::string& _path)
+{
+	std::ifstream input = std::ifstream(_path.data(), std::ios::in | std::ios::binary | std::ios::ate);
+	if (!input.is_open()) { return 0; }
+	uint64 fileSize = (uint64)input.tellg();
+	input.seekg(0);
+
+	tableSnapshot::header fileHeader;
+	input.read((char*)&fileHeader, sizeof(tableSnapshot::header));
+	if (input.fail() || fileHeader.magic != tableSnapshot::magic || fileHeader.version != tableSnapshot::version) { return 0; }
+	if (fileSize != sizeof(tableSnapshot::header) + fileHeader.recordCount * sizeof(uint64)) { return 0; } // (<- truncated file, or data after the records)
+
+	std::vector<uint64> records;
+	records.resize((size_t)fileHeader.recordCount);
+	input.read((char*)records.data(), records.size() * sizeof(uint64));
+	if (input.fail()) { return 0; }
+	if (tableSnapshot::getChecksum(records.data(), records.size()) != fileHeader.checksum) { return 0; }
+	for (uint64 i = 0; i < records.size(); i += 1) { if (!tableSnapshot::isValidRecord(records[i])) { return 0; } }
+
+	for (uint64 i = 0; i < records.size(); i += 1) { _table.store(records[i] >> 15, openingBook::unpack(records[i]), nBound::exact); }
+	return records.size();
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "ff/fftime.hpp"
+#include "ff/ffmath.hpp"
+
+#include "aiBoardEvaluation.hpp"
+#include "bitboard.hpp"
+
+namespace p4ai
+{
+	/// \brief Time budget of one move of the robot, spent by a single iterative search (see engine::runSearch())
+	/// \detail Soft limit: once a depth is finished past it, no new depth is worth starting and the move is played
+	/// Hard limit: the search stops past it, even in the middle of a depth (the last finished depth is played)
+	/// Both limits scale with the moves the robot has left to play, the soft one is shortened when the best column is stable, both are extended by half when the score drops
+	/// A proven win is played right away, a proven loss is not: the search keeps its budget, as on any other position
+	struct timeManager
+	{
+		static const uint stableDepthsToShorten = 4;	// finished depths in a row with the same best column before the soft limit is halved
+		static const uint referenceMovesLeft = 8;		// moves left at which the move gets exactly its nominal budget
+		static const uint minMovesLeft = 4;				// (<- short endgames are mostly solved long before their budget is used)
+		static const uint maxMovesLeft = 16;			// (<- the first moves get at most twice the nominal budget)
+
+		ff::timer timer;		// started with the move
+		uint softLimitMs = 0;
+		uint hardLimitMs = 0;
+
+		uint lastDepth = 0;		// last finished depth seen by update()
+		uint8 lastColumn = -1;	// best column of that depth
+		int lastScore = 0;
+		uint stableDepths = 0;	// finished depths in a row that kept the same best column
+		bool scoreDropped = false;	// the last finished depth scored lower than the previous one
+		bool won = false;		// the last finished depth proved a win (see update())
+
+		timeManager() {}
+
+		/// \brief Start the budget of a move
+		///
+		/// \param _board: Board the robot has to play on
+		/// \param _moveBudgetMs: Nominal thinking budget of a move
+		timeManager(const bitboard& _board, uint _moveBudgetMs);
+
+		/// \brief Take the result of the search into account, call it whenever the search may have finished a depth
+		///
+		/// \param _best: Best evaluation of the last finished depth
+		/// \param _depth: Last finished depth (0 if none)
+		void update(const boardEvaluation& _best, uint _depth);
+
+		/// \brief Get the soft limit, shortened when the best column is stable and extended when the score dropped
+		uint getAdjustedSoftLimitMs() const;
+
+		/// \brief Get the hard limit, extended when the score dropped (by as much as the soft limit)
+		uint getAdjustedHardLimitMs() const;
+
+		/// \brief Check if the move should be played now: a win is proven, a depth was finished past the soft limit, or the hard limit is reached
+		///
+		/// \param _depthFinished: A depth was finished since the last call
+		bool shouldStop(bool _depthFinished) const;
+
+		/// \brief Get how much time is left before the hard limit (extended when the score dropped)
+		uint getRemainingMs() const;
+	};
+}
+
+
+
+p4ai::timeManager::timeManager(const bitboard& _board, uint _moveBudgetMs)
+{
+	uint movesLeft = ff::minOf(ff::maxOf((_board.getTurnsLeft() + 1) / 2, minMovesLeft), maxMovesLeft); // (<- moves of the player to move, including this one)
+	softLimitMs = (uint)((uint64)_moveBudgetMs * movesLeft / referenceMovesLeft);
+	hardLimitMs = softLimitMs * 2;
+}
+void p4ai::timeManager::update(const boardEvaluation& _best, uint _depth)
+{
+	if (_depth <= lastDepth || _best.type != nEvaluation::exhaustive) { return; }
+
+	stableDepths = (_best.column == lastColumn) ? stableDepths + 1 : 0;
+	scoreDropped = lastDepth > 0 && _best.score < lastScore;
+	won = _best.score > 0; // (<- positions past the depth limit score 0: a positive score is a win proven within the depth)
+	lastDepth = _depth;
+	lastColumn = _best.column;
+	lastScore = _best.score;
+}
+uint p4ai::timeManager::getAdjustedSoftLimitMs() const
+{
+	if (scoreDropped) { return softLimitMs + softLimitMs / 2; }
+	if (stableDepths >= stableDepthsToShorten) { return softLimitMs / 2; }
+	return softLimitMs;
+}
+uint p4ai::timeManager::getAdjustedHardLimitMs() const { return scoreDropped ? hardLimitMs + hardLimitMs / 2 : hardLimitMs; }
+bool p4ai::timeManager::shouldStop(bool _depthFinished) const
+{
+	if (won) { return true; }
+	if (timer.waitedForMilli(getAdjustedHardLimitMs())) { return true; }
+	return _depthFinished && timer.waitedForMilli(getAdjustedSoftLimitMs());
+}
+uint p4ai::timeManager::getRemainingMs() const
+{
+	uint hardLimit = getAdjustedHardLimitMs();
+	return hardLimit - ff::minOf(timer.getMilli(), hardLimit);
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "ff/ffsetup.hpp"
+
+#include "bitboard.hpp"
+#include "aiBoardEvaluation.hpp"
+
+namespace p4ai
+{
+	/// \brief What a stored score says about the real score of the position (exact, lower, upper):
+	/// - exact: the score is the real score
+	/// - lower: the exploration stopped on a cutoff, the real score is at least this score
+	/// - upper: no move reached the window, the real score is at most this score
+	enum class nBound : char { exact, lower, upper };
+
+	/// \brief Transposition table mapping board keys to their evaluations, shared by every search thread
+	/// \detail Entries are grouped in buckets of 2 slots: one keeps the entry from the deepest exploration, the other always takes the latest entry
+	/// Each entry holds the generation it was stored in (bumped every move of the robot, and by several at the start of a game): entries of older generations are stale, a stale entry in the deepest slot is replaced whatever its depth
+	/// Lock-free: each slot is stored as two 64-bit words (key ^ data, data), written and read without locks
+	/// A slot torn by two threads writing it at the same time no longer validates against its key and is treated as missing
+	struct transpositionTable
+	{
+		/// \brief Size used by the table of the search until it is resized
+		static const uint defaultSizeMb = 64;
+
+		/// \brief Number of generations an entry stays fresh: the current one and the previous one (the move of the opponent, explored while pondering)
+		static const uint8 keptGenerations = 2;
+
+		struct slot
+		{
+			std::atomic<uint64> check; // key ^ data
+			std::atomic<uint64> data;  // packed evaluation and generation (0 if the slot is empty)
+		};
+		struct bucket
+		{
+			slot deepest;	// entry from the deepest exploration (replaced by deeper or equally deep entries)
+			slot latest;	// latest entry that did not go in the deepest slot
+		};
+
+		/// \brief Table usage counters (kept per thread, see transpositionCounters)
+		struct counters
+		{
+			uint64 probes = 0;
+			uint64 hits = 0;
+			uint64 misses = 0;
+			uint64 collisions = 0;	// misses on a bucket filled by other positions
+			uint64 stores = 0;
+			uint64 overwrites = 0;	// stores that replaced another position
+
+			counters operator-(const counters& _other) const;
+			counters& operator+=(const counters& _other);
+		};
+
+		std::vector<bucket> buckets;
+		uint indexShift = 64;
+		std::atomic<uint8> generation;	// generation of the entries stored now (wraps around)
+
+		/// \param _sizeMb: Memory used by the table in megabytes, rounded down to a power of two number of buckets [1, ...]
+		transpositionTable(uint _sizeMb);
+
+		/// \brief Change the memory used by the table, every entry is removed (must not be called while a search is running)
+		void resize(uint _sizeMb);
+
+		/// \brief Get the evaluation stored for a key
+		///
+		/// \param _key: Key of the board (bitboard::getKey())
+		/// \param _eval: RETURN VALUE of the stored evaluation, unchanged if the key is missing
+		/// \param _bound: RETURN VALUE of what the stored score says about the real score, unchanged if the key is missing
+		///
+		/// \return [true: if the key was found] [false: otherwise]
+		bool probe(uint64 _key, boardEvaluation& _eval, nBound& _bound) const;
+
+		/// \brief Store an exhaustive evaluation (score, depth of the exploration and best column)
+		/// \detail The entry goes in the deepest slot of its bucket if it is at least as deep as the entry there (which moves to the latest slot), in the latest slot otherwise
+		/// If the deepest slot already holds the same position, it is updated in place: a shallower entry only replaces it if it is exact or has a tighter bound with a proven score (a win or a loss: scores at the depth limit are 0, a heuristic bound never replaces a deeper one), otherwise the deeper entry is kept (a key is never in both slots)
+		void store(uint64 _key, const boardEvaluation& _eval, nBound _bound);
+
+		/// \brief Get the evaluation stored for a board or for its mirror (see bitboard::getCanonicalKey()), the stored column is mirrored back if needed
+		bool probe(const bitboard& _board, boardEvaluation& _eval, nBound& _bound) const;
+
+		/// \brief Store the evaluation of a board, shared with its mirror (see bitboard::getCanonicalKey())
+		void store(const bitboard& _board, const boardEvaluation& _eval, nBound _bound);
+
+		/// \brief Remove every entry (must not be called while a search is running)
+		void clear();
+
+		/// \brief Start a new generation: the entries stored before become stale after keptGenerations generations
+		///
+		/// \param _count: Number of generations to skip (keptGenerations: every entry stored before is stale right away)
+		void startNewGeneration(uint8 _count = 1);
+
+		/// \brief Check if a stored entry is from a generation that is no longer kept (see keptGenerations)
+		bool isStale(uint64 _data) const;
+
+		uint64 getBucketCount() const;
+		uint64 getSizeBytes() const;
+
+		uint64 getIndex(uint64 _key) const;
+		static uint64 pack(const boardEvaluation& _eval, nBound _bound, uint8 _generation);
+		static boardEvaluation unpack(uint64 _data);
+		static nBound unpackBound(uint64 _data);
+		static uint8 unpackGeneration(uint64 _data);
+		static uint8 mirrorColumn(uint8 _column);
+	};
+
+
+	/// \brief Usage counters of the transposition tables by the current thread
+	thread_local transpositionTable::counters transpositionCounters;
+}
+
+
+
+p4ai::transpositionTable::counters p4ai::transpositionTable::counters::operator-(const counters& _other) const
+{
+	counters result = *this;
+	result.probes -= _other.probes;
+	result.hits -= _other.hits;
+	result.misses -= _other.misses;
+	result.collisions -= _other.collisions;
+	result.stores -= _other.stores;
+	result.overwrites -= _other.overwrites;
+	return result;
+}
+p4ai::transpositionTable::counters& p4ai::transpositionTable::counters::operator+=(const counters& _other)
+{
+	probes += _other.probes;
+	hits += _other.hits;
+	misses += _other.misses;
+	collisions += _other.collisions;
+	stores += _other.stores;
+	overwrites += _other.overwrites;
+	return *this;
+}
+p4ai::transpositionTable::transpositionTable(uint _sizeMb) { generation.store(0); resize(_sizeMb); }
+void p4ai::transpositionTable::resize(uint _sizeMb)
+{
+	uint64 wantedBuckets = ff::maxOf((uint64)_sizeMb, (uint64)1) * 1024 * 1024 / sizeof(bucket);
+	uint sizeLog2 = 0;
+	while (((uint64)2 << sizeLog2) <= wantedBuckets) { sizeLog2 += 1; }
+
+	buckets = std::vector<bucket>((size_t)1 << sizeLog2);
+	indexShift = 64 - sizeLog2;
+	clear();
+}
+bool p4ai::transpositionTable::probe(uint64 _key, boardEvaluation& _eval, nBound& _bound) const
+{
+	transpositionCounters.probes += 1;
+
+	const bucket& target = buckets[getIndex(_key)];
+	bool filled = false;
+	const slot* slots[2] = { &target.deepest, &target.latest };
+	for (uint i = 0; i < 2; i += 1)
+	{
+		uint64 data = slots[i]->data.load(std::memory_order_relaxed);
+		uint64 check = slots[i]->check.load(std::memory_order_relaxed);
+		if (data == 0) { continue; }
+		filled = true;
+
+		if ((check ^ data) != _key) { continue; }
+		_eval = unpack(data);
+		_bound = unpackBound(data);
+		transpositionCounters.hits += 1;
+		return true;
+	}
+
+	transpositionCounters.misses += 1;
+	if (filled) { transpositionCounters.collisions += 1; }
+	return false;
+}
+void p4ai::transpositionTable::store(uint64 _key, const boardEvaluation& _eval, nBound _bound)
+{
+	transpositionCounters.stores += 1;
+
+	bucket& target = buckets[getIndex(_key)];
+	uint64 data = pack(_eval, _bound, generation.load(std::memory_order_relaxed));
+
+	uint64 deepestData = target.deepest.data.load(std::memory_order_relaxed);
+	uint64 deepestCheck = target.deepest.check.load(std::memory_order_relaxed);
+	bool deepestIsValid = deepestData != 0 && getIndex(deepestCheck ^ deepestData) == getIndex(_key); // (<- a torn slot validates against a key that does not belong here)
+	bool deepestIsSame = deepestIsValid && (deepestCheck ^ deepestData) == _key;
+	bool deepestIsStale = deepestIsValid && isStale(deepestData);
+
+	// Same position in the deepest slot, updated in place:
+	if (deepestIsSame && !deepestIsStale)
+	{
+		boardEvaluation deepestEval = unpack(deepestData);
+		nBound deepestBound = unpackBound(deepestData);
+		bool isTighter = _bound == deepestBound && ((_bound == nBound::lower && _eval.score > deepestEval.score) || (_bound == nBound::upper && _eval.score < deepestEval.score));
+		bool isProvenTighter = isTighter && _eval.score != 0; // (<- positions past the depth limit score 0: any other score is a win or a loss proven within the depth)
+		if (_eval.relativeDepth < deepestEval.relativeDepth && (deepestBound == nBound::exact || (_bound != nBound::exact && !isProvenTighter))) { return; } // (<- the deeper entry says more)
+
+		target.deepest.data.store(data, std::memory_order_relaxed);
+		target.deepest.check.store(_key ^ data, std::memory_order_relaxed);
+		return;
+	}
+
+	// Deepest slot (the entry it held moves to the latest slot, unless it is the same position or it is stale):
+	if (!deepestIsValid || deepestIsStale || unpack(deepestData).relativeDepth <= _eval.relativeDepth)
+	{
+		if (deepestIsValid && !deepestIsSame)
+		{
+			transpositionCounters.overwrites += 1;
+			if (!deepestIsStale)
+			{
+				target.latest.data.store(deepestData, std::memory_order_relaxed);
+				target.latest.check.store(deepestCheck, std::memory_order_relaxed);
+			}
+		}
+		target.deepest.data.store(data, std::memory_order_relaxed);
+		target.deepest.check.store(_key ^ data, std::memory_order_relaxed);
+		return;
+	}
+
+	// Latest slot:
+	uint64 latestData = target.latest.data.load(std::memory_order_relaxed);
+	uint64 latestCheck = target.latest.check.load(std::memory_order_relaxed);
+	if (latestData != 0 && (latestCheck ^ latestData) != _key) { transpositionCounters.overwrites += 1; }
+	target.latest.data.store(data, std::memory_order_relaxed);
+	target.latest.check.store(_key ^ data, std::memory_order_relaxed);
+}
+bool p4ai::transpositionTable::probe(const bitboard& _board, boardEvaluation& _eval, nBound& _bound) const
+{
+	bool isMirrored = false;
+	uint64 key = _board.getCanonicalKey(isMirrored);
+	if (!probe(key, _eval, _bound)) { return false; }
+
+	if (isMirrored) { _eval.column = mirrorColumn(_eval.column); }
+	return true;
+}
+void p4ai::transpositionTable::store(const bitboard& _board, const boardEvaluation& _eval, nBound _bound)
+{
+	bool isMirrored = false;
+	uint64 key = _board.getCanonicalKey(isMirrored);
+
+	boardEvaluation eval = _eval;
+	if (isMirrored) { eval.column = mirrorColumn(eval.column); }
+	store(key, eval, _bound);
+}
+void p4ai::transpositionTable::clear()
+{
+	for (uint64 i = 0; i < buckets.size(); i += 1)
+	{
+		buckets[i].deepest.check.store(0, std::memory_order_relaxed);
+		buckets[i].deepest.data.store(0, std::memory_order_relaxed);
+		buckets[i].latest.check.store(0, std::memory_order_relaxed);
+		buckets[i].latest.data.store(0, std::memory_order_relaxed);
+	}
+}
+void p4ai::transpositionTable::startNewGeneration(uint8 _count) { generation.store((uint8)(generation.load() + _count)); }
+bool p4ai::transpositionTable::isStale(uint64 _data) const { return (uint8)(generation.load(std::memory_order_relaxed) - unpackGeneration(_data)) >= keptGenerations; } // (<- wraps around with the generation)
+uint64 p4ai::transpositionTable::getBucketCount() const { return buckets.size(); }
+uint64 p4ai::transpositionTable::getSizeBytes() const { return buckets.size() * sizeof(bucket); }
+uint64 p4ai::transpositionTable::getIndex(uint64 _key) const { return (_key * 0x9E3779B97F4A7C15ull) >> indexShift; } // (<- keys are mixed, their low bits only describe the first column)
+uint64 p4ai::transpositionTable::pack(const boardEvaluation& _eval, nBound _bound, uint8 _generation)
+{
+	return (uint64)(uint8)_eval.score | ((uint64)_eval.relativeDepth << 8) | ((uint64)_eval.column << 16) | ((uint64)_bound << 24) | ((uint64)1 << 26) | ((uint64)_generation << 32); // (<- bit 26 marks the slot as used)
+}
+p4ai::boardEvaluation p4ai::transpositionTable::unpack(uint64 _data)
+{
+	boardEvaluation eval = boardEvaluation(nEvaluation::exhaustive, (int8)(uint8)(_data & 0xFF), (uint8)((_data >> 8) & 0xFF));
+	eval.column = (uint8)((_data >> 16) & 0xFF);
+	return eval;
+}
+p4ai::nBound p4ai::transpositionTable::unpackBound(uint64 _data) { return (nBound)((_data >> 24) & 0x3); }
+uint8 p4ai::transpositionTable::unpackGeneration(uint64 _data) { return (uint8)((_data >> 32) & 0xFF); }
+uint8 p4ai::transpositionTable::mirrorColumn(uint8 _column) { return (_column < bitboard::xSize) ? (uint8)(bitboard::xSize - 1 - _column) : _column; }
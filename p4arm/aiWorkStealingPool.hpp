@@ -0,0 +1,150 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <functional>
+
+#include "ff/ffsetup.hpp"
+#include "ff/ffmutex.hpp"
+
+#include "aiSearchStats.hpp"
+
+namespace p4ai
+{
+	/// \brief Thread pool where each thread has its own task deque: a thread pushes and pops tasks at the back of its deque, idle threads steal from the front of the others
+	/// \detail Deque 0 belongs to the thread that created the pool (it takes part by calling runOne() while it waits), deques [1, threadCount[ belong to the worker threads
+	struct workStealingPool
+	{
+		struct taskDeque
+		{
+			ff::mutex lock;
+			std::deque<std::function<void()>> tasks;
+		};
+
+		std::vector<taskDeque> deques;
+		std::vector<std::thread> workers;
+		std::atomic<bool> stopWorkers;
+		std::atomic<uint> queuedTasks;
+		ff::mutex workerStatsLock;
+		searchStats workerStats;			// measurements of the worker threads (added by the tasks, see addWorkerStats())
+
+		std::mutex sleepMtx;
+		std::condition_variable wakeUp;
+
+		/// \param _threadCount: Total number of threads, including the thread that created the pool [1, ...]
+		workStealingPool(uint _threadCount);
+		~workStealingPool();
+
+		/// \brief Push a task at the back of the current thread's deque
+		void push(std::function<void()> _task);
+
+		/// \brief Run one task: the last one pushed by the current thread, or one stolen from another thread
+		/// \return [true: if a task was run] [false: if every deque was empty]
+		bool runOne();
+
+		uint getThreadCount() const;
+
+		/// \brief Get the index of the current thread's deque in this pool (0 for the threads of other pools and for any thread that is not a pool worker)
+		uint getOwnDequeIdx() const;
+
+		/// \brief Add the measurements of a task run by a worker thread
+		void addWorkerStats(const searchStats& _stats);
+
+		/// \brief Get the measurements of every task run by the worker threads since the pool was created
+		searchStats getWorkerStats();
+
+		/// \brief Worker thread loop
+		void run(uint _dequeIdx);
+	};
+
+
+	/// \brief Pool the current thread is a worker of (nullptr for any thread that is not a pool worker), and the index of its deque in that pool
+	/// \detail A worker can push to or run the tasks of another pool (a pool replaced by one with another thread count, a benchmark pool): it then uses deque 0 of that pool, see getOwnDequeIdx()
+	thread_local const workStealingPool* currentPool = nullptr;
+	thread_local uint currentDequeIdx = 0;
+}
+
+
+
+p4ai::workStealingPool::workStealingPool(uint _threadCount) : deques(_threadCount > 0 ? _threadCount : 1)
+{
+	stopWorkers.store(false);
+	queuedTasks.store(0);
+	for (uint i = 1; i < deques.size(); i += 1) { workers.push_back(std::thread(&workStealingPool::run, this, i)); }
+}
+p4ai::workStealingPool::~workStealingPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMtx);
+		stopWorkers.store(true);
+	}
+	wakeUp.notify_all();
+	for (uint i = 0; i < workers.size(); i += 1) { workers[i].join(); }
+}
+void p4ai::workStealingPool::push(std::function<void()> _task)
+{
+	taskDeque& own = deques[getOwnDequeIdx()];
+	own.lock.lock();
+	own.tasks.push_back(_task);
+	own.lock.unlock();
+
+	queuedTasks.fetch_add(1);
+	wakeUp.notify_one();
+}
+bool p4ai::workStealingPool::runOne()
+{
+	std::function<void()> task;
+	bool found = false;
+
+	// Own deque first (newest task, its data is still in cache):
+	uint ownIdx = getOwnDequeIdx();
+	taskDeque& own = deques[ownIdx];
+	own.lock.lock();
+	if (!own.tasks.empty()) { task = own.tasks.back(); own.tasks.pop_back(); found = true; }
+	own.lock.unlock();
+
+	// Steal the oldest task of another thread (the biggest sub-tree):
+	for (uint i = 1; i < deques.size() && !found; i += 1)
+	{
+		taskDeque& other = deques[(ownIdx + i) % deques.size()];
+		other.lock.lock();
+		if (!other.tasks.empty()) { task = other.tasks.front(); other.tasks.pop_front(); found = true; }
+		other.lock.unlock();
+	}
+
+	if (!found) { return false; }
+	queuedTasks.fetch_sub(1);
+	task();
+	return true;
+}
+uint p4ai::workStealingPool::getThreadCount() const { return deques.size(); }
+uint p4ai::workStealingPool::getOwnDequeIdx() const { return (currentPool == this) ? currentDequeIdx : 0; }
+void p4ai::workStealingPool::addWorkerStats(const searchStats& _stats)
+{
+	workerStatsLock.lock();
+	workerStats += _stats;
+	workerStatsLock.unlock();
+}
+p4ai::searchStats p4ai::workStealingPool::getWorkerStats()
+{
+	workerStatsLock.lock();
+	searchStats result = workerStats;
+	workerStatsLock.unlock();
+	return result;
+}
+void p4ai::workStealingPool::run(uint _dequeIdx)
+{
+	currentPool = this;
+	currentDequeIdx = _dequeIdx;
+	while (!stopWorkers.load())
+	{
+		if (runOne()) { continue; }
+
+		std::unique_lock<std::mutex> lock(sleepMtx);
+		wakeUp.wait_for(lock, std::chrono::milliseconds(1), [this]() { return stopWorkers.load() || queuedTasks.load() > 0; });
+	}
+}
@@ -10,8 +10,21 @@
 /// \brief Namespace used to store operations on the uint64 bitboard representation
 namespace ops
 {
-	const uint xSize = 7;
-	const uint ySize = 6;
+	constexpr uint xSize = 7;
+	constexpr uint ySize = 6;
+
+	/// \brief Bottom cell of every column (each column takes ySize + 1 bits: its cells, then an always empty sentinel cell)
+	constexpr uint64 bottomRow = ((uint64(1) << xSize * (ySize + 1)) - 1) / ((uint64(1) << (ySize + 1)) - 1); // (<- 1 + 2^7 + 2^14 + ... + 2^42)
+
+	/// \brief Sentinel cell above the top cell of every column
+	constexpr uint64 sentinelRow = bottomRow << ySize;
+
+	/// \brief Every cell of the board (no sentinel cell, nothing past the last column)
+	constexpr uint64 boardMask = bottomRow * ((uint64(1) << ySize) - 1);
+
+	/// \brief Offset all cells by coordinates known at compile time: one shift and one mask, cells moved out of the board are removed
+	/// \detail A token crossing the top or the bottom of a column lands on a sentinel cell (removed) or in the next column, win patterns never cross columns because their cells are contiguous and sentinel cells are always empty
+	template<int X, int Y> constexpr uint64 offset(uint64 _cells);
 
 
 	/// \brief Offset all cells by coordinates
@@ -23,10 +36,10 @@ namespace ops
 	uint64 surround(uint64 _filledCells);
 
 	/// \brief Check if cells are aligned for a win
-	bool checkWin(uint64 _cells);
+	constexpr bool checkWin(uint64 _cells);
 
 	/// \brief Get the cells where dropping a token would give a win
-	uint64 getWinPositions(uint64 _filledCells, uint64 _playerCells);
+	constexpr uint64 getWinPositions(uint64 _filledCells, uint64 _playerCells);
 
 	/// \brief Get the cells where dropping a token is possible
 	uint64 getPlaceablePositions(uint64 _filledCells);
@@ -41,11 +54,21 @@ namespace ops
 	/// \brief Get the cell position when dropping a column
 	/// \param uint _x: x-th column [0, 6]
 	uint64 getColumnDropPosition(uint64 _filledCells, uint _x);
+
+	/// \brief Get the bottom cell of every column
+	uint64 getBottomRow();
+
+	/// \brief Get every cell of a column
+	/// \param uint _x: x-th column [0, 6]
+	constexpr uint64 getColumnMask(uint _x);
+
+	/// \brief Mirror cells from left to right (column x goes to column 6 - x)
+	uint64 mirror(uint64 _cells);
 		
 	/// \brief Get a cell given its coordinates
 	/// \param int _x: x coordinate of the cell [0, 6]
 	/// \param int _y: y coordinate of the cell [0, 6] (warning: using the value "6" will return an invalid cell position but is allowed)
-	uint64 getCellAt(uint _x, uint _y);
+	constexpr uint64 getCellAt(uint _x, uint _y);
 
 	/// \brief Get the string representation of the cells
 	ff::string getString(uint64 _cells);
@@ -69,6 +92,9 @@ struct bitboard
 	uint64 filledCells = 0;
 	uint8 moves = 0;
 
+	uint8 historySize = 0;
+	uint8 history[xSize * ySize] = {};	// columns played with play(), oldest first (entries from historySize on are unused)
+
 	/// \brief Get the type of the cell (empty, first player, second player)
 	/// \param uint _x: x coordinate of the cell [0, 6]
 	/// \param uint _y: y coordinate of the cell [0, 5]
@@ -82,6 +108,11 @@ struct bitboard
 	/// \return [>=1: one of the best possible moves], [0: could have won, didn't block immediate losing spot or placed token under a losing spot], [-1: impossible move]
 	int8 getColumnScore(uint _x) const;
 
+	/// \brief Get the number of threats the current player would have after dropping in the column (empty cells that would complete 4 in a row)
+	/// \param uint _x: x coordinate of the column to check [0, 6], the column must not be full
+	/// \return [0, ...]: more threats usually means a better move
+	uint getColumnThreats(uint _x) const;
+
 	/// \brief Check if a dropped token will be next to existing tokens
 	/// \param uint _x: x coordinate of the column to check [0, 6]
 	/// \return [true: the dropped token will be next to other tokens], [false]
@@ -93,9 +124,14 @@ struct bitboard
 	bool getDropIsNeighboringFriendly(uint _x) const;
 
 	/// \brief Get the state of the game (playing, first player won, second player won, draw, invalid state)
+	/// \detail Full validation (token counts, floating tokens, both players' lines): use it on untrusted boards (camera, edit mode)
 	nBoardStatus getStatus() const;
 
-	/// \brief Get the score of the board if the game ended, or a static evaluation otherwise
+	/// \brief Get the state of the game from the last move only: did the last mover connect four, is the board full (never invalid)
+	/// \detail Fast path for the search: only valid on boards reached by dropping tokens from a valid board that was still playing
+	nBoardStatus getLastMoveStatus() const;
+
+	/// \brief Get the score of the board if the game ended, or a static evaluation otherwise (uses getLastMoveStatus(), see its conditions)
 	/// \return int8: Score from the point of view of the player whose turn it is to play [-100, 100]
 	int8 getScore() const;
 
@@ -122,10 +158,35 @@ struct bitboard
 	/// \return [black: if the cell is empty] [red: if the cell has player 1's token] [yellow: if the cell has player 2's token]
 	ff::color getCellColor(uint _x, uint _y) const;
 
-	/// \brief Get the unique key associated with this board state
+	/// \brief Get the cells of the player whose turn it is to play
+	uint64 getCurrentPlayerCells() const;
+
+	/// \brief Get the cells where the current player can drop a token (one per column that is not full)
+	uint64 getPossibleMoves() const;
+
+	/// \brief Get the drop cells where the current player wins right away
+	uint64 getWinningMoves() const;
+
+	/// \brief Get the drop cells of the moves that do not lose to the next move of the opponent, in one pass of bit operations
+	/// \detail If the opponent can win right away, blocking is the only non-losing move (two such cells are a double threat: every move loses)
+	/// A token is never dropped right under a cell where the opponent would win, the opponent would then win on top of it
+	/// The current player must not be able to win right away (check getWinningMoves() first)
+	/// \return The drop cells, at most one per column [0: every move loses to the next move of the opponent]
+	uint64 possibleNonLosingMoves() const;
+
+	/// \brief Get the unique key associated with this board state: current player cells + filled cells + bottom row
+	/// \detail In each column, adding the bottom cell to the filled cells gives the cell above the top token, and the current player cells are all below it
+	/// So each 7-bit column of the key is the cell above the top token, with the current player tokens under it: two different boards always give two different keys
 	/// \return Unique key number (NOT a representation of the board)
 	uint64 getKey() const;
 
+	/// \brief Get the key of the board mirrored from left to right
+	uint64 getMirrorKey() const;
+
+	/// \brief Get the same key for this board and its mirror (the smallest of the two keys), boards that are mirrors of each other have the same score
+	/// \param _isMirrored: RETURN VALUE of [true: if the key is the key of the mirrored board, columns must then be mirrored (x -> 6 - x)] [false: otherwise]
+	uint64 getCanonicalKey(bool& _isMirrored) const;
+
 
 	bool operator==(const bitboard& _board) const;
 	bool operator!=(const bitboard& _board) const;
@@ -133,6 +194,18 @@ struct bitboard
 
 	bool canDropColumn(uint _x);
 	void dropColumn(uint _x);
+
+	/// \brief Drop a token in a column and remember the move, so that it can be taken back with undo()
+	/// \param uint _x: x coordinate of the column [0, 6], the column must not be full
+	void play(uint _x);
+
+	/// \brief Take back the last move made with play()
+	/// \return [true: if a move was taken back] [false: if no move made with play() is left]
+	bool undo();
+
+	/// \brief Play a sequence of moves, one digit per move, the digit being the column played ['1', '7'] (example: "4453")
+	/// \return [true: if every move could be played] [false: if a character is not a column, a column is full or the game ended before the last move]
+	bool playMoves(const ff::string& _moves);
 	uint getTurnsLeft() const;
 	uint getTurnsPlayed() const;
 	nBoardTurn getTurn() const;
@@ -147,61 +220,59 @@ struct bitboard
 
 
 
+namespace ops
+{
+	/// \brief Shift by a signed amount known at compile time (left if positive, right if negative)
+	template<int Shift, bool IsLeft = (Shift >= 0)> struct shift { static constexpr uint64 apply(uint64 _cells) { return _cells << Shift; } };
+	template<int Shift> struct shift<Shift, false> { static constexpr uint64 apply(uint64 _cells) { return _cells >> -Shift; } };
+}
+template<int X, int Y> constexpr uint64 ops::offset(uint64 _cells) { return shift<X * (int)(ySize + 1) + Y>::apply(_cells) & boardMask; }
 uint64 ops::offset(uint64 _cells, int _xDelta, int _yDelta)
 {
-	uint64 result = _cells;
-	if (_xDelta > 0) { result = result << (uint)_xDelta * (ops::ySize + 1); }
-	else { result = result >> (uint)(-_xDelta) * (ops::ySize + 1); }
-	if (_yDelta > 0) { result = result << _yDelta; }
-	else { result = result >> (-_yDelta); }
-
-	return (result) & ~(getCellAt(0, 6) + getCellAt(1, 6) + getCellAt(2, 6) + getCellAt(3, 6) + getCellAt(4, 6) + getCellAt(5, 6) + getCellAt(6, 6));
+	int shiftAmount = _xDelta * (int)(ySize + 1) + _yDelta;
+	return ((shiftAmount >= 0) ? (_cells << shiftAmount) : (_cells >> -shiftAmount)) & boardMask;
 }
 uint64 ops::surround(uint64 _filledCells)
 {
 	return (offset(_filledCells, 1, 0) | offset(_filledCells, 0, 1) | offset(_filledCells, -1, 0) | offset(_filledCells, 0, -1)) & ~_filledCells;
 }
-bool ops::checkWin(uint64 _cells)
+constexpr bool ops::checkWin(uint64 _cells)
 {
 	// Vertical
-	if ((_cells & offset(_cells, 0, 1) & offset(_cells, 0, 2) & offset(_cells, 0, 3)) != 0) { return true; }
+	if ((_cells & offset<0, 1>(_cells) & offset<0, 2>(_cells) & offset<0, 3>(_cells)) != 0) { return true; }
 	// Horizontal
-	if ((_cells & offset(_cells, 1, 0) & offset(_cells, 2, 0) & offset(_cells, 3, 0)) != 0) { return true; }
+	if ((_cells & offset<1, 0>(_cells) & offset<2, 0>(_cells) & offset<3, 0>(_cells)) != 0) { return true; }
 	// Diagonal up-right
-	if ((_cells & offset(_cells, 1, 1) & offset(_cells, 2, 2) & offset(_cells, 3, 3)) != 0) { return true; }
+	if ((_cells & offset<1, 1>(_cells) & offset<2, 2>(_cells) & offset<3, 3>(_cells)) != 0) { return true; }
 	// Diagonal down-right
-	if ((_cells & offset(_cells, 1, -1) & offset(_cells, 2, -2) & offset(_cells, 3, -3)) != 0) { return true; }
+	if ((_cells & offset<1, -1>(_cells) & offset<2, -2>(_cells) & offset<3, -3>(_cells)) != 0) { return true; }
 
 	return false;
 }
-uint64 ops::getWinPositions(uint64 _filledCells, uint64 _playerCells)
+constexpr uint64 ops::getWinPositions(uint64 _filledCells, uint64 _playerCells)
 {
 	uint64 result = 0;
 	// Vertical
-	result |= offset(_playerCells, 0, 1) & offset(_playerCells, 0, 2) & offset(_playerCells, 0, 3);
+	result |= offset<0, 1>(_playerCells) & offset<0, 2>(_playerCells) & offset<0, 3>(_playerCells);
 	// Horizontal
-	result |= offset(_playerCells, 1, 0) & offset(_playerCells, 2, 0) & offset(_playerCells, 3, 0); // (3 in a row)
-	result |= offset(_playerCells, -1, 0) & offset(_playerCells, -2, 0) & offset(_playerCells, -3, 0); // (3 in a row)
-	result |= offset(_playerCells, 1, 0) & offset(_playerCells, 2, 0) & offset(_playerCells, -1, 0); // (2 in a row + 1 spaced out)
-	result |= offset(_playerCells, -1, 0) & offset(_playerCells, -2, 0) & offset(_playerCells, 1, 0); // (1 spaced out + 2 in a row)
+	result |= offset<1, 0>(_playerCells) & offset<2, 0>(_playerCells) & offset<3, 0>(_playerCells); // (3 in a row)
+	result |= offset<-1, 0>(_playerCells) & offset<-2, 0>(_playerCells) & offset<-3, 0>(_playerCells); // (3 in a row)
+	result |= offset<1, 0>(_playerCells) & offset<2, 0>(_playerCells) & offset<-1, 0>(_playerCells); // (2 in a row + 1 spaced out)
+	result |= offset<-1, 0>(_playerCells) & offset<-2, 0>(_playerCells) & offset<1, 0>(_playerCells); // (1 spaced out + 2 in a row)
 	// Diagonal up-right
-	result |= offset(_playerCells, 1, 1) & offset(_playerCells, 2, 2) & offset(_playerCells, 3, 3); // (3 in a row)
-	result |= offset(_playerCells, -1, -1) & offset(_playerCells, -2, -2) & offset(_playerCells, -3, -3); // (3 in a row)
-	result |= offset(_playerCells, 1, 1) & offset(_playerCells, 2, 2) & offset(_playerCells, -1, -1); // (2 in a row + 1 spaced out)
-	result |= offset(_playerCells, -1, -1) & offset(_playerCells, -2, -2) & offset(_playerCells, 1, 1); // (1 spaced out + 2 in a row)
+	result |= offset<1, 1>(_playerCells) & offset<2, 2>(_playerCells) & offset<3, 3>(_playerCells); // (3 in a row)
+	result |= offset<-1, -1>(_playerCells) & offset<-2, -2>(_playerCells) & offset<-3, -3>(_playerCells); // (3 in a row)
+	result |= offset<1, 1>(_playerCells) & offset<2, 2>(_playerCells) & offset<-1, -1>(_playerCells); // (2 in a row + 1 spaced out)
+	result |= offset<-1, -1>(_playerCells) & offset<-2, -2>(_playerCells) & offset<1, 1>(_playerCells); // (1 spaced out + 2 in a row)
 	// Diagonal down-right
-	result |= offset(_playerCells, 1, -1) & offset(_playerCells, 2, -2) & offset(_playerCells, 3, -3); // (3 in a row)
-	result |= offset(_playerCells, -1, 1) & offset(_playerCells, -2, 2) & offset(_playerCells, -3, 3); // (3 in a row)
-	result |= offset(_playerCells, 1, -1) & offset(_playerCells, 2, -2) & offset(_playerCells, -1, 1); // (2 in a row + 1 spaced out)
-	result |= offset(_playerCells, -1, 1) & offset(_playerCells, -2, 2) & offset(_playerCells, 1, -1); // (1 spaced out + 2 in a row)
+	result |= offset<1, -1>(_playerCells) & offset<2, -2>(_playerCells) & offset<3, -3>(_playerCells); // (3 in a row)
+	result |= offset<-1, 1>(_playerCells) & offset<-2, 2>(_playerCells) & offset<-3, 3>(_playerCells); // (3 in a row)
+	result |= offset<1, -1>(_playerCells) & offset<2, -2>(_playerCells) & offset<-1, 1>(_playerCells); // (2 in a row + 1 spaced out)
+	result |= offset<-1, 1>(_playerCells) & offset<-2, 2>(_playerCells) & offset<1, -1>(_playerCells); // (1 spaced out + 2 in a row)
 
 	return result & ~_filledCells;
 }
-uint64 ops::getPlaceablePositions(uint64 _filledCells)
-{
-	uint64 forbiddenCells = getCellAt(0, 6) + getCellAt(1, 6) + getCellAt(2, 6) + getCellAt(3, 6) + getCellAt(4, 6) + getCellAt(5, 6) + getCellAt(6, 6);
-	return _filledCells + (getCellAt(0, 0) + getCellAt(1, 0) + getCellAt(2, 0) + getCellAt(3, 0) + getCellAt(4, 0) + getCellAt(5, 0) + getCellAt(6, 0)) & ~forbiddenCells;
-}
+uint64 ops::getPlaceablePositions(uint64 _filledCells) { return (_filledCells + bottomRow) & boardMask; }
 uint64 ops::getPlaceableWinPositions(uint64 _filledCells, uint64 _playerCells)
 {
 	uint64 winPositions = getWinPositions(_filledCells, _playerCells);
@@ -215,7 +286,17 @@ uint64 ops::getColumnDropPosition(uint64 _filledCells, uint _x)
 {
 	return _filledCells + ops::getCellAt(_x, 0) & ~_filledCells;
 }
-uint64 ops::getCellAt(uint _x, uint _y) { return uint64(1) << _x * (ySize + 1) << _y; }
+constexpr uint64 ops::getColumnMask(uint _x) { return ((uint64(1) << ySize) - 1) << _x * (ySize + 1); }
+uint64 ops::getBottomRow() { return bottomRow; }
+uint64 ops::mirror(uint64 _cells)
+{
+	const uint64 columnMask = (uint64(1) << (ySize + 1)) - 1;
+
+	uint64 result = 0;
+	for (uint x = 0; x < xSize; x += 1) { result |= ((_cells >> x * (ySize + 1)) & columnMask) << (xSize - 1 - x) * (ySize + 1); }
+	return result;
+}
+constexpr uint64 ops::getCellAt(uint _x, uint _y) { return uint64(1) << _x * (ySize + 1) << _y; }
 ff::string ops::getString(uint64 _cells)
 {
 	ff::string result = "";
@@ -304,6 +385,12 @@ int8 bitboard::getColumnScore(uint _x) const
 
 	return 1;
 }
+uint bitboard::getColumnThreats(uint _x) const
+{
+	uint64 dropCell = ops::getColumnDropPosition(filledCells, _x);
+	uint64 filledAfter = filledCells | dropCell;
+	return ff::bitops::countBits(ops::getWinPositions(filledAfter, getCurrentPlayerCells() | dropCell) & ~filledAfter);
+}
 bool bitboard::getDropIsNeighboring(uint _x) const
 {
 	uint64 neighbors = ops::surround(filledCells);
@@ -318,25 +405,12 @@ bool bitboard::getDropIsNeighboringFriendly(uint _x) const
 nBoardStatus bitboard::getStatus() const
 {
 	// Check for incorrect amount of tokens:
-	int p1Count = 0;
-	int p2Count = 0;
-	uint64 mask = uint64(1);
-	for (uint i = 0; i < xSize * (ySize + 1); i += 1)
-	{
-		p1Count += (mask & p1Cells) != 0;
-		p2Count += (mask & (filledCells & ~p1Cells)) != 0;
-		mask = mask << 1;
-	}
+	int p1Count = (int)ff::bitops::countBits(p1Cells);
+	int p2Count = (int)ff::bitops::countBits(filledCells & ~p1Cells);
 	if (p2Count > p1Count || p1Count > p2Count + 1) { return nBoardStatus::invalid; }
 
-	// Check for "floating" tokens:
-	for (uint i = 0; i < 7; i += 1)
-	{
-		for (int j = 1; j < 6; j += 1)
-		{
-			if (((filledCells & ops::getCellAt(i, j)) != 0) && ((filledCells & ops::getCellAt(i, j - 1)) == 0)) { return nBoardStatus::invalid; }
-		}
-	}
+	// Check for "floating" tokens (every token must be on the bottom row or on another token):
+	if ((filledCells & ~(ops::offset<0, 1>(filledCells) | ops::bottomRow)) != 0) { return nBoardStatus::invalid; }
 
 	// Check for win conditions:
 	if (ops::checkWin(p1Cells)) { return nBoardStatus::firstPlayerWon; }
@@ -345,9 +419,15 @@ nBoardStatus bitboard::getStatus() const
 
 	return nBoardStatus::playing;
 }
+nBoardStatus bitboard::getLastMoveStatus() const
+{
+	if (ops::checkWin(filledCells & ~getCurrentPlayerCells())) { return (getTurn() == nBoardTurn::firstPlayer) ? nBoardStatus::secondPlayerWon : nBoardStatus::firstPlayerWon; } // (<- only the last mover can have connected four)
+	if (moves == xSize * ySize) { return nBoardStatus::draw; }
+	return nBoardStatus::playing;
+}
 int8 bitboard::getScore() const
 {
-	nBoardStatus gameType = getStatus();
+	nBoardStatus gameType = getLastMoveStatus();
 	if (gameType == nBoardStatus::firstPlayerWon || gameType == nBoardStatus::secondPlayerWon) { return -((int)getTurnsLeft() / 2 + 1); } // if somebody won, it is now the opposite player's turn to play, therefore the score is negative
 	else if (gameType == nBoardStatus::draw) { return 0; }
 	return -55;
@@ -383,9 +463,33 @@ ff::color bitboard::getCellColor(uint _x, uint _y) const
 	else if (getCellType(_x, _y) == nBoardSlot::secondPlayer) { return ff::color::yellow(); }
 	else { return ff::color::black(); }
 }
+uint64 bitboard::getCurrentPlayerCells() const { return (getTurn() == nBoardTurn::firstPlayer) ? p1Cells : (filledCells & ~p1Cells); }
+uint64 bitboard::getPossibleMoves() const { return ops::getPlaceablePositions(filledCells); }
+uint64 bitboard::getWinningMoves() const { return ops::getWinPositions(filledCells, getCurrentPlayerCells()) & getPossibleMoves(); }
+uint64 bitboard::possibleNonLosingMoves() const
+{
+	uint64 possible = getPossibleMoves();
+	uint64 opponentWins = ops::getWinPositions(filledCells, filledCells & ~getCurrentPlayerCells()) & ~filledCells;
+
+	uint64 forced = possible & opponentWins;
+	if (forced != 0)
+	{
+		if ((forced & (forced - 1)) != 0) { return 0; } // (<- more than one cell to block)
+		possible = forced;
+	}
+	return possible & ~(opponentWins >> 1);
+}
 uint64 bitboard::getKey() const
 {
-	return p1Cells + filledCells;
+	return getCurrentPlayerCells() + filledCells + ops::getBottomRow();
+}
+uint64 bitboard::getMirrorKey() const { return ops::mirror(getKey()); } // (<- each column of the key only depends on the same column of the board)
+uint64 bitboard::getCanonicalKey(bool& _isMirrored) const
+{
+	uint64 key = getKey();
+	uint64 mirrorKey = getMirrorKey();
+	_isMirrored = mirrorKey < key;
+	return _isMirrored ? mirrorKey : key;
 }
 bool bitboard::operator==(const bitboard& _board) const
 {
@@ -410,6 +514,36 @@ void bitboard::dropColumn(uint _x)
 	filledCells |= filledCells + bottomCell;
 	moves += 1;
 }
+void bitboard::play(uint _x)
+{
+	if (!canDropColumn(_x) || historySize >= xSize * ySize) { return; }
+
+	history[historySize] = (uint8)_x;
+	historySize += 1;
+	dropColumn(_x);
+}
+bool bitboard::undo()
+{
+	if (historySize == 0) { return false; }
+
+	historySize -= 1;
+	uint64 column = filledCells & ops::getColumnMask(history[historySize]);
+	uint64 topCell = (column + ops::getCellAt(history[historySize], 0)) >> 1; // (<- the cells of a column are contiguous from the bottom: the cell above the top token, moved down)
+	p1Cells &= ~topCell;
+	filledCells &= ~topCell;
+	moves -= 1;
+	return true;
+}
+bool bitboard::playMoves(const ff::string& _moves)
+{
+	for (uint i = 0; i < _moves.size(); i += 1)
+	{
+		if (_moves[i] < '1' || _moves[i] > '7') { return false; }
+		if (getStatus() != nBoardStatus::playing || !canDropColumn(_moves[i] - '1')) { return false; }
+		dropColumn(_moves[i] - '1');
+	}
+	return true;
+}
 uint bitboard::getTurnsLeft() const { return (xSize * ySize) - moves; }
 uint bitboard::getTurnsPlayed() const { return moves; }
 nBoardTurn bitboard::getTurn() const { return (moves % 2 == 0) ? nBoardTurn::firstPlayer : nBoardTurn::secondPlayer; }
@@ -435,3 +569,14 @@ ff::string bitboard::getString() const
 
 
 
+
+
+// Compile-time checks of the shift kernels:
+static_assert(ops::offset<1, 0>(ops::getCellAt(0, 0)) == ops::getCellAt(1, 0), "offset<1, 0> moves a cell to the next column");
+static_assert(ops::offset<-1, 1>(ops::getCellAt(3, 2)) == ops::getCellAt(2, 3), "offset<-1, 1> moves a cell up and to the previous column");
+static_assert(ops::offset<0, 1>(ops::getCellAt(4, ops::ySize - 1)) == 0, "a cell moved above the top row leaves the board");
+static_assert(ops::offset<1, 0>(ops::getCellAt(ops::xSize - 1, 0)) == 0, "a cell moved past the last column leaves the board");
+static_assert(ops::checkWin(ops::getCellAt(0, 0) | ops::getCellAt(1, 1) | ops::getCellAt(2, 2) | ops::getCellAt(3, 3)), "diagonal win");
+static_assert(!ops::checkWin(ops::getCellAt(0, 4) | ops::getCellAt(0, 5) | ops::getCellAt(1, 0) | ops::getCellAt(1, 1)), "a vertical line does not continue in the next column");
+static_assert(ops::getWinPositions(0, ops::getCellAt(4, 0) | ops::getCellAt(5, 0) | ops::getCellAt(6, 0)) == ops::getCellAt(3, 0), "3 in a row against the last column has one win position");
+static_assert(ops::getWinPositions(ops::getCellAt(0, 0), ops::getCellAt(1, 0) | ops::getCellAt(3, 0) | ops::getCellAt(4, 0)) == ops::getCellAt(2, 0), "filled cells are not win positions");
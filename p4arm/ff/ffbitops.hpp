@@ -1,12 +1,16 @@
-
 #pragma once
 
 #include "ffsetup.hpp"
 
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
 namespace ff
 {
 	namespace bitops
 	{
+		/// \brief Count the bits set to 1 (one popcount instruction)
 		uint countBits(uint _value);
 		uint countBits(uint64 _value);
 	}
@@ -15,21 +19,19 @@ namespace ff
 
 uint ff::bitops::countBits(uint _value)
 {
-	uint result = 0;
-	while (_value > 0)
-	{
-		if (_value % 2 == 1) { result += 1; }
-		_value = _value >> 1;
-	}
-	return result;
+#if defined(_MSC_VER)
+	return __popcnt(_value);
+#else
+	return __builtin_popcount(_value);
+#endif
 }
 uint ff::bitops::countBits(uint64 _value)
 {
-	uint result = 0;
-	while (_value > 0)
-	{
-		if (_value % 2 == 1) { result += 1; }
-		_value = _value >> 1;
-	}
-	return result;
+#if defined(_MSC_VER) && defined(_M_X64)
+	return (uint)__popcnt64(_value);
+#elif defined(_MSC_VER)
+	return __popcnt((uint)_value) + __popcnt((uint)(_value >> 32)); // (<- no 64-bit popcount in 32-bit builds)
+#else
+	return __builtin_popcountll(_value);
+#endif
 }
@@ -6,8 +6,9 @@
 
 #include "fflog.hpp"
 
-#include <windows.h>
 #include <string>
+#if defined(_WIN32)
+#include <windows.h>
 ff::unistring getCurrentDirectory()
 {
 	WCHAR buffer[MAX_PATH];
@@ -15,6 +16,16 @@ ff::unistring getCurrentDirectory()
 	std::wstring::size_type position = std::wstring(buffer).find_last_of(L"\\/");
 	return std::wstring(buffer).substr(0, position);
 }
+#else
+#include <unistd.h>
+ff::unistring getCurrentDirectory()
+{
+	char buffer[4096];
+	ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer));
+	std::string path = (length > 0) ? std::string(buffer, (size_t)length) : std::string(".");
+	return path.substr(0, path.find_last_of('/'));
+}
+#endif
 
 enum class nLoadFile { success = 0, fileIsFolder, fileNotFound, fileCantRead };
 
@@ -42,12 +42,12 @@ namespace ff
 	};
 }
 
-ff::interval<uint8>& ff::interval<uint8>::shrinkEndToFit(uint8 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
-ff::interval<uint16>& ff::interval<uint16>::shrinkEndToFit(uint16 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
-ff::interval<uint32>& ff::interval<uint32>::shrinkEndToFit(uint32 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
-ff::interval<uint64>& ff::interval<uint64>::shrinkEndToFit(uint64 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
-ff::interval<int8>& ff::interval<int8>::shrinkEndToFit(int8 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
-ff::interval<int16>& ff::interval<int16>::shrinkEndToFit(int16 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
-ff::interval<int32>& ff::interval<int32>::shrinkEndToFit(int32 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
-ff::interval<int64>& ff::interval<int64>::shrinkEndToFit(int64 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
+template<> ff::interval<uint8>& ff::interval<uint8>::shrinkEndToFit(uint8 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
+template<> ff::interval<uint16>& ff::interval<uint16>::shrinkEndToFit(uint16 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
+template<> ff::interval<uint32>& ff::interval<uint32>::shrinkEndToFit(uint32 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
+template<> ff::interval<uint64>& ff::interval<uint64>::shrinkEndToFit(uint64 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
+template<> ff::interval<int8>& ff::interval<int8>::shrinkEndToFit(int8 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
+template<> ff::interval<int16>& ff::interval<int16>::shrinkEndToFit(int16 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
+template<> ff::interval<int32>& ff::interval<int32>::shrinkEndToFit(int32 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
+template<> ff::interval<int64>& ff::interval<int64>::shrinkEndToFit(int64 _includedValue) { if (_includedValue < end) { end = _includedValue + 1; } return *this; }
 template<typename T> ff::interval<T>& ff::interval<T>::shrinkEndToFit(T _includedValue) { if (_includedValue < end) { end = _includedValue; } return *this; }
@@ -6,7 +6,15 @@
 #include "ffcolortext.hpp"
 #include <iostream>
 
-#include <Windows.h>
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	// No console colors outside of Windows:
+	typedef void* HANDLE;
+	inline HANDLE GetStdHandle(int) { return nullptr; }
+	inline int SetConsoleTextAttribute(HANDLE, uint16) { return 0; }
+	#define STD_OUTPUT_HANDLE 0
+#endif
 
 namespace nLogCategory { enum type { always = 0, debug }; }
 
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ffsetup.hpp"
+#include "ffstring.hpp"
+#include "ffrawmem.hpp"
+
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+namespace ff
+{
+	/// \brief Read-only view of a whole file mapped in memory (pages are loaded by the system when first read)
+	struct mappedfile
+	{
+		ff::rawmem mem;
+
+#if defined(_WIN32)
+		HANDLE fileHandle = INVALID_HANDLE_VALUE;
+		HANDLE mapHandle = NULL;
+#else
+		int fileDescriptor = -1;
+#endif
+
+		mappedfile() {}
+		mappedfile(const mappedfile&) = delete;
+		mappedfile& operator=(const mappedfile&) = delete;
+		~mappedfile();
+
+		/// \brief Map a file (the previously mapped file is closed)
+		/// \return [true: if the file was mapped] [false: if it could not be opened, or is empty]
+		bool open(const ff::string& _path);
+		void close();
+
+		bool isOpen() const;
+	};
+}
+
+
+
+ff::mappedfile::~mappedfile() { close(); }
+bool ff::mappedfile::open(const ff::string& _path)
+{
+	close();
+
+#if defined(_WIN32)
+	fileHandle = CreateFileA((LPCSTR)_path.data(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) { return false; }
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) { close(); return false; }
+
+	mapHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapHandle == NULL) { close(); return false; }
+
+	mem = ff::rawmem((byte*)MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0), (uint)fileSize.QuadPart);
+	if (mem.address == nullptr) { close(); return false; }
+#else
+	fileDescriptor = ::open(_path.data(), O_RDONLY);
+	if (fileDescriptor < 0) { return false; }
+
+	struct stat fileInfo;
+	if (fstat(fileDescriptor, &fileInfo) != 0 || fileInfo.st_size == 0) { close(); return false; }
+
+	void* address = mmap(nullptr, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (address == MAP_FAILED) { close(); return false; }
+	mem = ff::rawmem((byte*)address, (uint)fileInfo.st_size);
+#endif
+
+	return true;
+}
+void ff::mappedfile::close()
+{
+#if defined(_WIN32)
+	if (mem.address != nullptr) { UnmapViewOfFile(mem.address); }
+	if (mapHandle != NULL) { CloseHandle(mapHandle); }
+	if (fileHandle != INVALID_HANDLE_VALUE) { CloseHandle(fileHandle); }
+	mapHandle = NULL;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (mem.address != nullptr) { munmap(mem.address, mem.size); }
+	if (fileDescriptor >= 0) { ::close(fileDescriptor); }
+	fileDescriptor = -1;
+#endif
+	mem = ff::rawmem();
+}
+bool ff::mappedfile::isOpen() const { return mem.address != nullptr; }
@@ -3,6 +3,7 @@
 
 #include "ffsetup.hpp"
 #include <iostream>
+#include <cstring>
 
 namespace ff
 {
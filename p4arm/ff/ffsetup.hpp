@@ -1,6 +1,7 @@
 
 #pragma once
 
+#if defined(_MSC_VER)
 typedef unsigned __int8 byte;
 
 typedef __int8 int8;
@@ -13,4 +14,21 @@ typedef unsigned __int8 uint8;
 typedef unsigned __int16 uint16;
 typedef unsigned __int32 uint32;
 typedef unsigned __int64 uint64;
+#else
+// Same sizes and signedness as the MSVC sized integers (a plain char is unsigned on ARM, int8 must be a signed char to hold negative scores):
+typedef unsigned char byte;
+
+typedef signed char int8;
+typedef short int16;
+typedef int int32;
+typedef long long int64;
+
+typedef unsigned int uint;
+typedef unsigned char uint8;
+typedef unsigned short uint16;
+typedef unsigned int uint32;
+typedef unsigned long long uint64;
+#endif
+
+static_assert((int8)-1 < 0, "int8 must be signed");
 
@@ -1,7 +1,11 @@
 
 #pragma once
 
-#include <Windows.h>
+#if defined(_WIN32)
+	#include <Windows.h>
+#else
+	#include <thread>
+#endif
 
 #include <chrono>
 #include "ffsetup.hpp"
@@ -33,7 +37,11 @@ namespace ff
 
 
 	timer sleepTimer = timer();
+#if defined(_WIN32)
 	void sleep(uint _milliseconds) { Sleep(_milliseconds); }
+#else
+	void sleep(uint _milliseconds) { std::this_thread::sleep_for(std::chrono::milliseconds(_milliseconds)); }
+#endif
 }
 
 
@@ -110,8 +110,16 @@
 
 
 
+#include <thread>
+
 #include <SFML/Window.hpp>
 #include "p4states.hpp"
+#include "aiTableSnapshot.hpp"
+
+
+/// \brief Snapshot of the transposition table, loaded at startup and saved periodically (on a thread of its own, the UI loop never waits for it) and on exit (warm start after a restart)
+const char* tableSnapshotPath = "transpositions.bin";
+const uint tableSnapshotIntervalMs = 5 * 60 * 1000;
 
 
 
@@ -128,6 +136,10 @@ int main()
 	ff::timer ticks;
 
 	bot.config.load();
+	p4ai::book.load("openingbook.bin"); // (<- optional, the engine searches every position without it)
+	p4ai::loadTableSnapshot(p4ai::transpositions, tableSnapshotPath); // (<- results of the previous runs, see saveTableSnapshot())
+	ff::timer snapshotTimer;
+	std::thread snapshotSaver;
 
 
 	p4ui::initMainMenu();
@@ -208,8 +220,17 @@ int main()
 		window.clear();		  //
 		p4ui::draw(window);	  // 
 		window.display();	  // "Clear, draw, display" section to display the new image to the window
+
+		// Also saved periodically, the program is not always closed normally (the table can be saved while searches are running, see saveTableSnapshot()):
+		if (snapshotTimer.tickEveryMilli(tableSnapshotIntervalMs))
+		{
+			if (snapshotSaver.joinable()) { snapshotSaver.join(); } // (<- the previous save ended long ago)
+			snapshotSaver = std::thread([]() { p4ai::saveTableSnapshot(p4ai::transpositions, tableSnapshotPath); });
+		}
 	}
 
+	if (snapshotSaver.joinable()) { snapshotSaver.join(); }
+	p4ai::saveTableSnapshot(p4ai::transpositions, tableSnapshotPath);
 
 	return 0;
 }
@@ -1,147 +1,401 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "ff/ffmapdynarray.hpp"
-#include "ff/ffhashmaparray.hpp"
 #include "ff/fftime.hpp"
 #include "ff/ffinterval.hpp"
 
 #include "bitboard.hpp"
 #include "aiBoardEvaluation.hpp"
 #include "aiColumnOrder.hpp"
+#include "aiTranspositionTable.hpp"
+#include "aiWorkStealingPool.hpp"
+#include "aiMoveHistory.hpp"
+#include "aiPrincipalVariation.hpp"
+#include "aiSearchStats.hpp"
 
 namespace p4ai
 {
-	/// \brief Hash map mapping board keys to their exhaustive evaluations
-	ff::hashmaparray<uint64, boardEvaluation, 30000> hashMap;
+	/// \brief Transposition table mapping board keys to their evaluations, shared by every search thread (resize it at startup to use more or less memory)
+	transpositionTable transpositions = transpositionTable(transpositionTable::defaultSizeMb);
+
+	/// \brief Table used by the searches of the current thread instead of transpositions (nullptr: transpositions)
+	/// \detail For threads that each search their own positions (see p4analyse): the threads of a parallel search must all use the same table
+	thread_local transpositionTable* threadTable = nullptr;
+
+	/// \brief Get the table used by the searches of the current thread (see threadTable)
+	transpositionTable& getTranspositionTable();
+
+	/// \brief Flag that aborts the searches of the current thread when set, in addition to their timeout (nullptr: no flag)
+	/// \detail Read at every node: another thread can stop a search within a node by setting it (see engine::abortRunning)
+	thread_local const std::atomic<bool>* abortSignal = nullptr;
+
+	/// \brief Timeout checks of the searches of the current thread: the clock is only read every interval nodes, the interval adapts to the nodes/s so that it is read about once per millisecond
+	/// \detail Reading the clock costs about as much as exploring a node, reading it at every node was a measurable share of the search
+	struct timeoutPolling
+	{
+		static const uint minInterval = 16;
+		static const uint maxInterval = 1 << 20;
+
+		uint interval = 1024;		// nodes between two clock reads
+		uint nodesUntilPoll = 0;
+		ff::timer sincePoll;		// time since the last clock read, used to adapt the interval
+
+		/// \brief Count a node, and every interval nodes check if a search is out of time
+		///
+		/// \param _timer: Timer of the search
+		/// \param _timeoutMs: Time budget of the search
+		///
+		/// \return True if the clock was read and the search is out of time or out of nodes (see searchNodeLimit)
+		bool isTimedOut(const ff::timer& _timer, uint _timeoutMs);
+	};
+	thread_local timeoutPolling timeoutPoll;
+
+	/// \brief Node budget shared by every thread of the running search (0: no limit), a search past it is aborted like a search past its timeout
+	/// \detail Checked when the clock is read: each read adds the nodes explored since the previous one to searchNodesSpent (see timeoutPolling::isTimedOut(), engine::start())
+	std::atomic<uint64> searchNodeLimit(0);
+	std::atomic<uint64> searchNodesSpent(0);
+
+	/// \brief How the columns of a node are ordered before being explored (centerFirst, threatCount):
+	/// - centerFirst: from the center to the sides
+	/// - threatCount: by the number of threats the move gives (bitboard::getColumnThreats()), ties from the center to the sides
+	enum class nMoveOrdering : char { centerFirst, threatCount };
+
+	/// \brief Move ordering used by every search (set it before starting a search)
+	nMoveOrdering moveOrdering = nMoveOrdering::threatCount;
+
+	/// \brief Priority of the column explored first in a node (the best column stored or given), above every other priority
+	const int firstColumnPriority = 1 << 30;
+
+	/// \brief Minimum depth left to explore for a node to share its younger brothers with other threads (smaller sub-trees are not worth the synchronisation)
+	const uint minSplitDepth = 6;
+
+	/// \brief Get the window containing every possible score
+	ff::interval<int> fullWindow();
+
+	/// \brief Get the window that a child (immediate move) has to be explored with, given the window of its parent
+	/// \detail Scores are negated from one player to the other, so the included values [start, end - 1] become [-(end - 1), -start]
+	ff::interval<int> getChildWindow(ff::interval<int> _window);
+
+	/// \brief Get what a score found while exploring with a window says about the real score: scores strictly inside of the window are exact, the others are only bounds
+	///
+	/// \param _window: The window the position was explored with
+	/// \param _score: The score found
+	/// \param _bestPossibleScore: The best score the position can reach (a lower bound equal to it is exact)
+	nBound getScoreBound(ff::interval<int> _window, int _score, int _bestPossibleScore);
+
+	/// \brief Get the priority of a column in the exploration order of a node (see moveOrdering and useMoveHistory), higher is explored first
+	/// \detail The threat count comes first, then the history score, then the killer moves of the ply
+	///
+	/// \param _board: Board of the node
+	/// \param _column: Column to play, must not be full
+	/// \param _ply: Depth of the node from the root of the search
+	int getColumnPriority(const bitboard& _board, uint8 _column, uint _ply);
 
 	/// \brief Move exploration function, returns best explored move for a given board
-	/// \detail You can keep calling this function repeatedly even if it did not give a finished result in the given time, because it saves exploration progress in the hashmap
+	/// \detail You can keep calling this function repeatedly even if it did not give a finished result in the given time, because it saves exploration progress in the transposition table
 	/// 
 	/// \param _board: The starting position to explore
 	/// \param _wantedDepth: How deep to explore for moves (more = better result but takes more time to finish)
 	/// \param _timeoutMs: How much time the function is given before it times out (even if the function times out, progress is stored for the next function call)
+	/// \param _window: The alpha-beta window of the scores worth exploring (narrow it around a previous score for an aspiration window)
+	/// \param _expectedLine: Line explored first, as long as its columns can be played (usually the line of a previous search, see expectedLine)
+	/// \param _pool: Threads that explore the younger brothers of each node in parallel (nullptr: explore on the current thread only)
+	/// \param _line: RETURN VALUE of the line expected from the position, starting with the column of the evaluation (nullptr: not needed)
 	/// 
 	/// \return The evaluation, which can be finished (exhaustive) or incomplete (aborted), and can contain a valid column to play (check with .isPlayable())
-	boardEvaluation getPositionScoreNegamaxStart(bitboard _board, uint _wantedDepth, uint _timeoutMs);
+	boardEvaluation getPositionScoreNegamaxStart(bitboard _board, uint _wantedDepth, uint _timeoutMs, ff::interval<int> _window = fullWindow(), const principalVariation& _expectedLine = principalVariation(), workStealingPool* _pool = nullptr, principalVariation* _line = nullptr);
 
 
 	/// \brief Recursive move exploration function used by the above function
 	///
-	/// \param _board: Board to explore
+	/// \param _board: Board to explore, in place: moves are played and undone on it (unchanged when the function returns)
 	/// \param _window: The alpha-beta window used for alpha-beta pruning
 	/// \param _maxDepth: The maximum depth to explore to
 	/// \param _depth: The current depth relative to starting position
 	/// \param _timeoutMs: How much time the function has until timeout is reached
 	/// \param _timer: Timer used for timeout
+	/// \param _pool: Threads that explore the younger brothers of each node in parallel (nullptr: explore on the current thread only)
 	/// 
 	/// \return The evaluation, which can be finished (exhaustive) or incomplete (aborted), and can contain a valid column to play (check with .isPlayable())
-	boardEvaluation getPositionScoreNegamax(bitboard _board, ff::interval<int> _window, uint _maxDepth, uint _depth, uint _timeoutMs, const ff::timer& _timer = ff::timer());
+	boardEvaluation getPositionScoreNegamax(bitboard& _board, ff::interval<int> _window, uint _maxDepth, uint _depth, uint _timeoutMs, const ff::timer& _timer = ff::timer(), workStealingPool* _pool = nullptr);
+
+	/// \brief Explore a child of a node with principal variation search
+	/// \detail Once a brother scored inside of the window, it is expected to stay the best move: the next brothers are explored with a null window first, which only tells if they beat it
+	/// Only a brother that beats it is explored again with the window of the node, to get its score
+	///
+	/// \param _board: Board of the node, with the move of the child played
+	/// \param _window: The alpha-beta window of the node (not of the child)
+	/// \param _nullWindowFirst: [true: a brother already scored inside of the window, try a null window first] [false: explore with the window of the node]
+	/// \param _maxDepth: The maximum depth to explore to
+	/// \param _depth: The depth of the child relative to starting position
+	/// \param _timeoutMs: How much time the function has until timeout is reached
+	/// \param _timer: Timer used for timeout
+	/// \param _pool: Threads that explore the younger brothers of each node in parallel (nullptr: explore on the current thread only)
+	///
+	/// \return The evaluation of the child (from the point of view of the child)
+	boardEvaluation exploreChild(bitboard& _board, ff::interval<int> _window, bool _nullWindowFirst, uint _maxDepth, uint _depth, uint _timeoutMs, const ff::timer& _timer, workStealingPool* _pool);
+
+
+	/// \brief Node whose younger brothers are explored in parallel (Young Brothers Wait: the eldest brother is always explored first, alone, so that its score can prune the others)
+	/// \detail Each younger brother is a task of the work-stealing pool, the thread owning the node runs tasks while it waits for them
+	/// Brothers share the window of the node: each score found narrows it for the brothers explored afterwards, and a cutoff cancels every brother still being explored
+	struct splitPoint
+	{
+		bitboard board;
+		uint maxDepth = 0;
+		uint depth = 0;
+		uint timeoutMs = 0;
+		const ff::timer* timer = nullptr;
+		const std::atomic<bool>* abortSignal = nullptr;	// abort flag of the thread owning the node, given to the threads exploring its brothers
+		splitPoint* parent = nullptr;						// split point the node belongs to (nullptr: not explored by a task)
+
+		ff::mutex lock;					// protects window and eval
+		ff::interval<int> window;
+		boardEvaluation eval;
+		principalVariation line;		// line of the node, rebuilt whenever a brother improves eval
+		std::atomic<bool> cutoff;
+		std::atomic<uint> pendingTasks;
+
+		/// \brief Check if this split point or one of its ancestors had a cutoff (every search under it can stop)
+		bool isCancelled() const;
+
+		/// \brief Explore the given younger brothers as tasks of the pool and wait for all of them, running tasks meanwhile
+		///
+		/// \param _columns: Columns of the younger brothers, in exploration order
+		/// \param _columnCount: Number of columns
+		/// \param _pool: Pool the tasks are pushed to
+		void exploreBrothers(const uint8* _columns, uint _columnCount, workStealingPool* _pool);
+
+		/// \brief Explore one younger brother (task run by any thread of the pool)
+		void exploreBrother(uint8 _column, workStealingPool* _pool);
+	};
+
+	/// \brief Split point of the task the current thread is running (nullptr: no task)
+	thread_local splitPoint* currentSplit = nullptr;
+
+
+	/// \brief Iterative deepening search: explores depth 1, 2, 3... and always keeps the result of the last finished depth (anytime search)
+	/// \detail Each depth starts with the previous best column and an aspiration window around the previous score, the window is reopened if the score falls outside of it
+	struct iterativeSearch
+	{
+		/// \brief Half-width of the aspiration window around the previous score
+		static const int aspirationDelta = 2;
+
+		bitboard board;
+		uint maxDepth = 0;
+		workStealingPool* pool = nullptr;	// threads sharing the exploration of each depth (nullptr: explore on the current thread only)
+
+		uint depth = 1;					// depth currently being explored
+		ff::interval<int> window;		// window used for the current depth
+		boardEvaluation best;			// result of the last finished depth (aborted if no depth is finished yet)
+		principalVariation bestLine;	// line of the best result, followed first by the next depth (can be set before the first step to seed the search)
+		uint bestDepth = 0;				// depth of the best result (0 if no depth is finished yet)
+		boardEvaluation current;		// result of the last step (can be partial)
+		principalVariation currentLine;	// line of the last step
+		searchStats stats;				// measurements of every step, including the threads of the pool
+
+		iterativeSearch() {}
+		iterativeSearch(bitboard _board, uint _maxDepth);
+
+		/// \brief Continue exploring the current depth, moves to the next depth once it is finished
+		/// \detail Progress is stored in the transposition table, so a depth can be explored over several steps
+		///
+		/// \param _timeoutMs: How much time the step is given before it times out
+		void step(uint _timeoutMs);
+
+		/// \brief Check if every wanted depth has been explored
+		bool isFinished() const;
+
+		/// \brief Get the best evaluation available right now (the last finished depth, or the partial result if no depth is finished yet)
+		boardEvaluation getBest() const;
+
+		/// \brief Get the line of the best evaluation available right now (see getBest())
+		principalVariation getBestLine() const;
+	};
 }
 
-p4ai::boardEvaluation p4ai::getPositionScoreNegamaxStart(bitboard _board, uint _wantedDepth, uint _timeoutMs)
+p4ai::transpositionTable& p4ai::getTranspositionTable() { return (threadTable != nullptr) ? *threadTable : transpositions; }
+bool p4ai::timeoutPolling::isTimedOut(const ff::timer& _timer, uint _timeoutMs)
+{
+	if (nodesUntilPoll > 0) { nodesUntilPoll -= 1; return false; }
+	if (_timer.waitedForMilli(_timeoutMs)) { return true; } // (<- the clock is read again at every node until the search has returned, so that no brother is explored past the timeout)
+
+	uint64 nodeLimit = searchNodeLimit.load(std::memory_order_relaxed);
+	if (nodeLimit > 0 && searchNodesSpent.fetch_add(interval + 1, std::memory_order_relaxed) + interval + 1 >= nodeLimit) { return true; } // (<- same as the timeout: checked again at every node)
+
+	// Aim at one clock read per millisecond (twice as many nodes if none passed, fewer if several did):
+	uint elapsedMs = sincePoll.stopwatchMilli();
+	if (elapsedMs == 0) { interval = ff::minOf(interval * 2, maxInterval); }
+	else if (elapsedMs > 1) { interval = ff::maxOf(interval / elapsedMs, minInterval); }
+	nodesUntilPoll = interval;
+	return false;
+}
+ff::interval<int> p4ai::fullWindow() { return ff::interval<int>(-100, 101); }
+ff::interval<int> p4ai::getChildWindow(ff::interval<int> _window) { return ff::interval<int>(-_window.getMaxValue(), -_window.getMinValue() + 1); }
+p4ai::nBound p4ai::getScoreBound(ff::interval<int> _window, int _score, int _bestPossibleScore)
+{
+	if (_score <= _window.getMinValue()) { return nBound::upper; }	// (<- no move reached the window)
+	if (_score == _bestPossibleScore) { return nBound::exact; }
+	if (_score >= _window.getMaxValue()) { return nBound::lower; }	// (<- cutoff)
+	return nBound::exact;
+}
+int p4ai::getColumnPriority(const bitboard& _board, uint8 _column, uint _ply)
+{
+	int priority = 0;
+	if (moveOrdering == nMoveOrdering::threatCount) { priority += (int)ff::minOf(_board.getColumnThreats(_column), (uint)31) << 22; }
+	if (useMoveHistory)
+	{
+		priority += (int)cutoffMemory.getHistory(_board, _column) << 2;	// (<- below 1 << 22, never overrides a threat)
+		priority += (int)cutoffMemory.getKillerRank(_ply, _column);		// (<- below 1 << 2, only breaks history ties: ranking killer moves above the threats cost nodes in the benchmarks)
+	}
+	return priority;
+}
+p4ai::boardEvaluation p4ai::getPositionScoreNegamaxStart(bitboard _board, uint _wantedDepth, uint _timeoutMs, ff::interval<int> _window, const principalVariation& _expectedLine, workStealingPool* _pool, principalVariation* _line)
 {
+	if (_line != nullptr) { _line->length = 0; }
+
 	// Final state:
-	nBoardStatus status = _board.getStatus();
+	nBoardStatus status = _board.getLastMoveStatus();
 	if (status == nBoardStatus::firstPlayerWon || status == nBoardStatus::secondPlayerWon || status == nBoardStatus::draw)
 	{
-		int score = _board.getScore();
-		hashMap[_board.getKey()] = boardEvaluation(nEvaluation::exhaustive, score, 50);
-		return boardEvaluation(nEvaluation::exhaustive, score, 50);
+		return boardEvaluation(nEvaluation::exhaustive, _board.getScore(), 50);
 	}
 
 
 	// Pruning:
-	const int bestPossibleScore = 18;
-	ff::interval<int> window = ff::interval<int>(-100, 101);
-	window.shrinkEndToFit(bestPossibleScore);
+	const int bestPossibleScore = (_board.getTurnsLeft() + 1) / 2; // (<- winning with the next move)
+	_window.shrinkEndToFit(bestPossibleScore);
+	const ff::interval<int> searchedWindow = _window;
+
+	// Age the cutoff memory of this thread if a new move of the game started:
+	cutoffMemory.catchUpAge();
 
+	// Follow the expected line, or without one, explore the best column stored for this position first:
+	expectedLine = _expectedLine;
+	pvLines[0].length = 0;
+	uint8 firstColumn = expectedLine[0];
+	boardEvaluation stored;
+	nBound storedBound;
+	if (firstColumn == (uint8)-1 && getTranspositionTable().probe(_board, stored, storedBound)) { firstColumn = stored.column; }
 
-	// Choose columns to explore:
-	int8 threshold = -1;
-	for (uint i = 0; i < 7; i += 1) { if (_board.getColumnScore(i) >= 1) { threshold = 0; } }
+
+	// Choose columns to explore (a winning move if there is one, the non-losing moves otherwise, every move if they all lose: a column is always chosen):
+	uint64 moves = _board.getWinningMoves();
+	if (moves == 0) { moves = _board.possibleNonLosingMoves(); }
+	if (moves == 0) { moves = _board.getPossibleMoves(); }
 	columnOrder columns;
 	uint8 colOrder[7] = { 3, 2, 4, 1, 5, 0, 6 };
 	for (uint i = 0; i < 7; i += 1)
 	{
-		if (!_board.canDropColumn(colOrder[i])) { continue; }
-		if (_board.getColumnScore(colOrder[i]) <= threshold) { continue; }
-		columns.addColumn(colOrder[i], _board.getColumnScore(colOrder[i]));
+		if ((moves & ops::getColumnMask(colOrder[i])) == 0) { continue; }
+		columns.addColumn(colOrder[i], (colOrder[i] == firstColumn) ? firstColumnPriority : getColumnPriority(_board, colOrder[i], 0)); // (<- the first column is always explored first)
 	}
 
 
-	// Explore possible moves:
+	// Explore possible moves (the columns share the whole budget: time left unused by a column goes to the next ones):
+	ff::timer timer;
 	boardEvaluation eval = boardEvaluation();
-	ff::timer timeout;
-	for (uint iLoop = 0; iLoop < 1; iLoop += 1)
+	for (uint i = 0; i < columns.size(); i += 1)
 	{
-		eval = boardEvaluation();
-		window = ff::interval<int>(-100, 101);
-		window.shrinkEndToFit(bestPossibleScore);
+		// Pruning:
+		if (eval.type != nEvaluation::aborted && eval.score >= _window.getMaxValue()) { continue; }
 
-		for (uint i = 0; i < columns.size(); i += 1)
+		_board.play(columns[i]);
+		bool updated = eval.updateWithChild(exploreChild(_board, _window, i > 0 && eval.score == _window.getMinValue(), _wantedDepth, 1, _timeoutMs, timer, _pool), columns[i]);
+		_board.undo();
+		if (updated)
 		{
-			// Pruning:
-			if (eval.type != nEvaluation::aborted && eval.score >= window.getMaxValue()) { continue; }
-
-			bitboard cpy = _board;
-			cpy.dropColumn(columns[i]);
-
-			bool updated = false;
-			if (hashMap.contains(cpy.getKey()) && hashMap[cpy.getKey()].type == nEvaluation::exhaustive && (uint)(hashMap[cpy.getKey()].relativeDepth + 1) >= _wantedDepth)
-			{
-				updated = eval.updateWithChild(hashMap[cpy.getKey()], columns[i]);
-			}
-			else
-			{
-				updated = eval.updateWithChild(getPositionScoreNegamax(cpy, ff::interval<int>(-window.end, -window.start), _wantedDepth, 1, _timeoutMs / columns.size(), ff::timer()), columns[i]);
-			}
-
-			if (updated)
-			{
-				window.shrinkStartToFit(eval.score + 1);
-			}
+			_window.shrinkStartToFit(eval.score);
+			pvLines[0].setWithContinuation(columns[i], pvLines[1]);
 		}
 	}
 
-	// Save result:
-	if (eval.type == nEvaluation::exhaustive)
+	// Save result (a score outside of the window is only a bound):
+	if (eval.type == nEvaluation::exhaustive && eval.score != -100)
 	{
-		if (!hashMap.wouldOverwrite(_board.getKey()) || hashMap[_board.getKey()].relativeDepth < eval.relativeDepth) { hashMap[_board.getKey()] = eval; }
+		getTranspositionTable().store(_board, eval, getScoreBound(searchedWindow, eval.score, bestPossibleScore));
+	}
+
+	// Expected line, completed where the search stopped early (immediate wins and losses, stored results): a winning move, the best column stored in the transposition table, or any move if they all lose
+	if (_line != nullptr)
+	{
+		*_line = pvLines[0];
+		for (uint i = 0; i < _line->length; i += 1) { _board.play(_line->columns[i]); }
+		while (_line->length < _wantedDepth && _board.getLastMoveStatus() == nBoardStatus::playing)
+		{
+			uint64 moves = _board.getWinningMoves();
+			if (moves == 0 && _board.possibleNonLosingMoves() == 0) { moves = _board.getPossibleMoves(); }
+			uint8 column = -1;
+			for (uint x = 0; x < bitboard::xSize && column == (uint8)-1; x += 1) { if ((moves & ops::getColumnMask(x)) != 0) { column = x; } }
+			if (column == (uint8)-1 && getTranspositionTable().probe(_board, stored, storedBound) && stored.column < bitboard::xSize && _board.canDropColumn(stored.column)) { column = stored.column; }
+			if (column == (uint8)-1) { break; }
+
+			_line->columns[_line->length] = column;
+			_line->length += 1;
+			_board.play(column);
+		}
 	}
 	return eval;
 }
-p4ai::boardEvaluation p4ai::getPositionScoreNegamax(bitboard _board, ff::interval<int> _window, uint _maxDepth, uint _depth, uint _timeoutMs, const ff::timer& _timer)
+p4ai::boardEvaluation p4ai::getPositionScoreNegamax(bitboard& _board, ff::interval<int> _window, uint _maxDepth, uint _depth, uint _timeoutMs, const ff::timer& _timer, workStealingPool* _pool)
 {
+	threadStats.nodes += 1;
+	if (_depth > threadStats.maxPly) { threadStats.maxPly = _depth; }
+	pvLines[_depth].length = 0;
+
 	// Final state:
-	nBoardStatus status = _board.getStatus();
+	nBoardStatus status = _board.getLastMoveStatus();
 	if (status == nBoardStatus::firstPlayerWon || status == nBoardStatus::secondPlayerWon || status == nBoardStatus::draw)
 	{
-		int score = _board.getScore();
-		hashMap[_board.getKey()] = boardEvaluation(nEvaluation::exhaustive, score, _maxDepth - _depth);
-		return boardEvaluation(nEvaluation::exhaustive, score, _maxDepth - _depth);
+		return boardEvaluation(nEvaluation::exhaustive, _board.getScore(), _maxDepth - _depth);
 	}
 
 	// Timeout & depth limit:
-	if (_timer.waitedForMilli(_timeoutMs)) { return boardEvaluation(nEvaluation::aborted); }
-	if (_depth >= _maxDepth) { return boardEvaluation(nEvaluation::exhaustive, 0); }
+	if ((abortSignal != nullptr && abortSignal->load(std::memory_order_relaxed)) || timeoutPoll.isTimedOut(_timer, _timeoutMs)) { return boardEvaluation(nEvaluation::aborted); }
+	if (currentSplit != nullptr && currentSplit->isCancelled()) { return boardEvaluation(nEvaluation::aborted); } // (<- a brother of an ancestor already caused a cutoff)
+	if (_depth >= _maxDepth) { return boardEvaluation(nEvaluation::exhaustive, (int8)0, 0); } // (<- unknown outcome past the depth limit, scored as a draw)
+
+	// Immediate win, or loss whatever the move:
+	if (_board.getWinningMoves() != 0) { return boardEvaluation(nEvaluation::exhaustive, (int8)((_board.getTurnsLeft() + 1) / 2), _maxDepth - _depth); }
+	uint64 moves = _board.possibleNonLosingMoves();
+	if (moves == 0) { return boardEvaluation(nEvaluation::exhaustive, (int8)(-(int)_board.getTurnsLeft() / 2), _maxDepth - _depth); } // (<- the opponent wins with its next move)
 
 	// Pruning:
-	int bestPossibleScore = (_board.getTurnsLeft() / 2);
+	int bestPossibleScore = ((int)_board.getTurnsLeft() - 1) / 2; // (<- winning with the move after the next one, the next one cannot win)
 	_window.shrinkEndToFit(bestPossibleScore);
-	if (_window.size() <= 0) { return boardEvaluation(nEvaluation::exhaustive, _maxDepth - _depth); }
+	const ff::interval<int> searchedWindow = _window;
+	if (_window.getMaxValue() <= _window.getMinValue()) { return boardEvaluation(nEvaluation::exhaustive, bestPossibleScore, _maxDepth - _depth); } // (<- even the best possible score is too low to be worth exploring)
+
+	// Transposition table (a stored score is used if it comes from a deep enough exploration, and if it is exact or a bound outside of the window):
+	uint8 storedColumn = -1;
+	boardEvaluation stored;
+	nBound storedBound;
+	if (getTranspositionTable().probe(_board, stored, storedBound))
+	{
+		storedColumn = stored.column;
+		if (stored.relativeDepth >= _maxDepth - _depth)
+		{
+			if (storedBound == nBound::exact) { return stored; }
+			if (storedBound == nBound::lower && stored.score >= _window.getMaxValue()) { return stored; }
+			if (storedBound == nBound::upper && stored.score <= _window.getMinValue()) { return stored; }
+		}
+	}
 
 
-	// Choose columns to explore:
-	int8 threshold = -1;
-	for (uint i = 0; i < 7; i += 1) { if (_board.getColumnScore(i) >= 1) { threshold = 0; } }
+	// Choose columns to explore (non-losing moves only, the column of the expected line first, or the stored best column):
+	uint8 firstColumn = getExpectedColumn(_board, _depth);
+	if (firstColumn == (uint8)-1) { firstColumn = storedColumn; }
 	columnOrder columns;
 	uint8 colOrder[7] = { 3, 2, 4, 1, 5, 0, 6 };
 	for (uint i = 0; i < 7; i += 1)
 	{
-		if (_board.getColumnScore(colOrder[i]) <= threshold) { continue; }
-		columns.addColumn(colOrder[i], _board.getColumnScore(colOrder[i]));
+		if ((moves & ops::getColumnMask(colOrder[i])) == 0) { continue; }
+		columns.addColumn(colOrder[i], (colOrder[i] == firstColumn) ? firstColumnPriority : getColumnPriority(_board, colOrder[i], _depth));
 	}
+	threadStats.interiorNodes += 1;
 
 	// Explore possible moves:
 	boardEvaluation eval = boardEvaluation();
@@ -150,31 +404,184 @@ p4ai::boardEvaluation p4ai::getPositionScoreNegamax(bitboard _board, ff::interva
 		// Pruning:
 		if (eval.type != nEvaluation::aborted && eval.score >= _window.getMaxValue()) { continue; }
 
-		bitboard cpy = _board;
-		cpy.dropColumn(columns[i]);
-
-		bool updated = false;
-		if (hashMap.contains(cpy.getKey()) && hashMap[cpy.getKey()].type == nEvaluation::exhaustive && (uint)(hashMap[cpy.getKey()].relativeDepth + 1) >= _maxDepth - _depth)
+		// Young Brothers Wait: once the eldest brother is explored, the younger ones are shared with the other threads:
+		if (i == 1 && _pool != nullptr && _maxDepth - _depth >= minSplitDepth && eval.type != nEvaluation::aborted)
 		{
-			updated = eval.updateWithChild(hashMap[cpy.getKey()], columns[i]);
-		}
-		else
-		{
-			updated = eval.updateWithChild(getPositionScoreNegamax(cpy, ff::interval<int>(-_window.end, -_window.start), _maxDepth, _depth + 1, _timeoutMs, _timer), columns[i]);
+			splitPoint split;
+			split.board = _board;
+			split.maxDepth = _maxDepth;
+			split.depth = _depth;
+			split.timeoutMs = _timeoutMs;
+			split.timer = &_timer;
+			split.window = _window;
+			split.eval = eval;
+			split.line = pvLines[_depth];
+
+			uint8 brothers[7];
+			for (uint j = i; j < columns.size(); j += 1) { brothers[j - i] = columns[j]; }
+			split.exploreBrothers(brothers, columns.size() - i, _pool);
+
+			eval = split.eval;
+			_window = split.window;
+			pvLines[_depth] = split.line;
+			break;
 		}
 
+		_board.play(columns[i]);
+		bool updated = eval.updateWithChild(exploreChild(_board, _window, i > 0 && eval.score == _window.getMinValue(), _maxDepth, _depth + 1, _timeoutMs, _timer, _pool), columns[i]);
+		_board.undo();
 		if (updated)
 		{
-			_window.shrinkStartToFit(eval.score + 1);
+			_window.shrinkStartToFit(eval.score);
+			pvLines[_depth].setWithContinuation(columns[i], pvLines[_depth + 1]);
 		}
 	}
 
 
-	// Save result:
-	if (eval.type == nEvaluation::exhaustive)
+	// Count the cutoff, and remember the column that caused it for the next nodes:
+	if (eval.type == nEvaluation::exhaustive && eval.isPlayable() && eval.score >= _window.getMaxValue())
 	{
-		if (!hashMap.wouldOverwrite(_board.getKey()) || hashMap[_board.getKey()].relativeDepth < eval.relativeDepth) { hashMap[_board.getKey()] = eval; }
+		threadStats.cutoffs += 1;
+		if (eval.column == columns[0]) { threadStats.firstMoveCutoffs += 1; }
+		if (useMoveHistory) { cutoffMemory.addCutoff(_board, eval.column, _depth, _maxDepth - _depth); }
+	}
+
+	// Save result (a score outside of the window is only a bound):
+	if (eval.type == nEvaluation::exhaustive && eval.score != -100)
+	{
+		getTranspositionTable().store(_board, eval, getScoreBound(searchedWindow, eval.score, bestPossibleScore));
 	}
 
 	return eval;
 }
+
+p4ai::boardEvaluation p4ai::exploreChild(bitboard& _board, ff::interval<int> _window, bool _nullWindowFirst, uint _maxDepth, uint _depth, uint _timeoutMs, const ff::timer& _timer, workStealingPool* _pool)
+{
+	if (_nullWindowFirst && _window.getMaxValue() - _window.getMinValue() > 1)
+	{
+		int alpha = _window.getMinValue();
+		boardEvaluation child = getPositionScoreNegamax(_board, getChildWindow(ff::interval<int>(alpha, alpha + 2)), _maxDepth, _depth, _timeoutMs, _timer, _pool); // (<- window [alpha, alpha + 1])
+		if (child.type == nEvaluation::aborted || child.score == -100) { return child; }
+		if (-child.score <= alpha || -child.score >= _window.getMaxValue()) { return child; } // (<- does not beat the best score, or causes a cutoff: the bound is enough)
+		_window = ff::interval<int>(-child.score - 1, _window.getMaxValue() + 1); // (<- the child scores at least -child.score)
+	}
+
+	return getPositionScoreNegamax(_board, getChildWindow(_window), _maxDepth, _depth, _timeoutMs, _timer, _pool);
+}
+
+
+bool p4ai::splitPoint::isCancelled() const
+{
+	for (const splitPoint* split = this; split != nullptr; split = split->parent)
+	{
+		if (split->cutoff.load(std::memory_order_relaxed)) { return true; }
+	}
+	return false;
+}
+void p4ai::splitPoint::exploreBrothers(const uint8* _columns, uint _columnCount, workStealingPool* _pool)
+{
+	abortSignal = p4ai::abortSignal;
+	parent = currentSplit;
+	cutoff.store(false);
+	pendingTasks.store(_columnCount);
+
+	for (uint i = 0; i < _columnCount; i += 1)
+	{
+		uint8 column = _columns[i];
+		_pool->push([this, column, _pool]() { exploreBrother(column, _pool); });
+	}
+
+	// Help while waiting (own tasks first, they are on top of the deque):
+	while (pendingTasks.load() > 0)
+	{
+		if (!_pool->runOne()) { std::this_thread::yield(); }
+	}
+}
+void p4ai::splitPoint::exploreBrother(uint8 _column, workStealingPool* _pool)
+{
+	boardEvaluation child = boardEvaluation(nEvaluation::aborted);
+	principalVariation childLine;
+	if (!isCancelled())
+	{
+		bitboard cpy = board;
+		cpy.play(_column);
+		cutoffMemory.catchUpAge(); // (<- this thread may not have searched since the last move of the game)
+
+		lock.lock();
+		ff::interval<int> nodeWindow = window; // (<- the latest window, narrowed by the brothers already explored)
+		bool nullWindowFirst = eval.score == window.getMinValue();
+		lock.unlock();
+
+		// The lines below the node may be in use by nodes this thread was exploring before it took the task:
+		principalVariation savedLines[principalVariation::maxLength + 1];
+		for (uint i = depth + 1; i <= principalVariation::maxLength; i += 1) { savedLines[i] = pvLines[i]; }
+
+		// Run as part of this split point:
+		splitPoint* previousSplit = currentSplit;
+		const std::atomic<bool>* previousAbortSignal = p4ai::abortSignal;
+		bool outermostTask = _pool->getOwnDequeIdx() != 0 && previousSplit == nullptr; // (<- task of a worker thread, nested tasks are counted in it)
+		searchStats statsStart;
+		if (outermostTask) { threadStats.maxPly = 0; statsStart = getThreadStats(); }
+		currentSplit = this;
+		p4ai::abortSignal = abortSignal;
+
+		child = exploreChild(cpy, nodeWindow, nullWindowFirst, maxDepth, depth + 1, timeoutMs, *timer, _pool);
+		childLine = pvLines[depth + 1];
+		for (uint i = depth + 1; i <= principalVariation::maxLength; i += 1) { pvLines[i] = savedLines[i]; }
+
+		currentSplit = previousSplit;
+		p4ai::abortSignal = previousAbortSignal;
+		if (outermostTask) { _pool->addWorkerStats(getThreadStats() - statsStart); }
+	}
+
+	lock.lock();
+	if (!(child.type == nEvaluation::aborted && cutoff.load())) // (<- brothers aborted by the cutoff do not change the result)
+	{
+		if (eval.updateWithChild(child, _column)) { window.shrinkStartToFit(eval.score); line.setWithContinuation(_column, childLine); }
+		if (eval.type != nEvaluation::aborted && eval.score >= window.getMaxValue()) { cutoff.store(true); }
+	}
+	lock.unlock();
+
+	pendingTasks.fetch_sub(1); // (<- last access: the owner may return as soon as this reaches 0)
+}
+
+
+p4ai::iterativeSearch::iterativeSearch(bitboard _board, uint _maxDepth)
+{
+	board = _board;
+	maxDepth = ff::minOf(_maxDepth, _board.getTurnsLeft());
+	window = fullWindow();
+	best = boardEvaluation(nEvaluation::aborted);
+	current = boardEvaluation(nEvaluation::aborted);
+}
+void p4ai::iterativeSearch::step(uint _timeoutMs)
+{
+	if (isFinished()) { return; }
+
+	ff::timer timer;
+	threadStats.maxPly = 0;
+	searchStats statsStart = getThreadStats();
+	searchStats workerStatsStart = (pool != nullptr) ? pool->getWorkerStats() : searchStats();
+
+	current = getPositionScoreNegamaxStart(board, depth, _timeoutMs, window, bestLine, pool, &currentLine);
+
+	stats += getThreadStats() - statsStart;
+	if (pool != nullptr) { stats += pool->getWorkerStats() - workerStatsStart; }
+	stats.timeMs += timer.getMilli();
+	if (current.type != nEvaluation::exhaustive) { return; }
+
+	// Score outside of the aspiration window: explore the same depth again with the full window
+	bool failedLow = current.score <= window.getMinValue() || !current.isPlayable();
+	bool failedHigh = current.score >= window.getMaxValue() && window.getMaxValue() < fullWindow().getMaxValue();
+	if ((failedLow || failedHigh) && !(window == fullWindow())) { window = fullWindow(); return; }
+
+	best = current;
+	bestLine = currentLine;
+	bestDepth = depth;
+	stats.depth = bestDepth;
+	depth += 1;
+	window = ff::interval<int>(best.score - aspirationDelta, best.score + aspirationDelta + 1);
+}
+bool p4ai::iterativeSearch::isFinished() const { return depth > maxDepth; }
+p4ai::boardEvaluation p4ai::iterativeSearch::getBest() const { return (best.type == nEvaluation::exhaustive) ? best : current; }
+p4ai::principalVariation p4ai::iterativeSearch::getBestLine() const { return (best.type == nEvaluation::exhaustive) ? bestLine : currentLine; }
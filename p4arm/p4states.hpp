@@ -1,6 +1,6 @@
 
 #pragma once
-#include "p4ai.hpp"
+#include "aiEngine.hpp"
 #include "p4ui.hpp"
 #include "p4dobot.hpp"
 #include "p4camera.hpp"
@@ -20,6 +20,16 @@ namespace p4
 		/// \brief Current state of the program
 		nState currentState = nState::waitingForPlayer;
 
+		/// \brief Search submitted to the engine while thinking, and the board it was submitted for
+		p4ai::searchHandle currentSearch = 0;
+		bitboard currentSearchBoard;
+		bool hasCurrentSearch = false;
+
+		/// \brief Search settings used when thinking (depths are explored one after the other, the last finished depth is played when the time manager stops the search)
+		/// \detail The budget is nominal: the engine spends up to twice as much on the first moves, less on the last ones, and stops early once the best column is stable or a win is proven (see p4ai::timeManager)
+		const uint searchDepth = bitboard::xSize * bitboard::ySize;
+		const uint moveBudgetMs = 3000;
+
 
 		/// \brief Tick function for states, call this function to attempt to change states by getting a new webcam image and checking UI
 		///
@@ -58,14 +68,27 @@ p4::states::nState p4::states::tick(dobot& _dobot, cvimage& _debugImg, uiExchang
 
 	if (currentState == nState::thinking)
 	{
-		if (_exchange.board.getTurn() == nBoardTurn::firstPlayer) { currentState = nState::waitingForPlayer; _exchange.editMode = true; return currentState; } // If it's the player's turn to move, cancel and switch to waiting for player (this should not happen)
+		if (_exchange.board.getTurn() == nBoardTurn::firstPlayer) { p4ai::searchEngine.cancel(currentSearch); hasCurrentSearch = false; currentState = nState::waitingForPlayer; _exchange.editMode = true; return currentState; } // If it's the player's turn to move, cancel and switch to waiting for player (this should not happen)
 
 
-		p4ai::boardEvaluation eval = p4ai::getPositionScoreNegamaxStart(_exchange.board, 8, 10);														   //
-		if (eval.type != p4ai::nEvaluation::exhaustive) { ff::log() << "Evaluating moves... Current: " << eval.getString() << "\n"; return currentState; } //
-		if (!eval.isPlayable()) { ff::log() << "Evaluation does not provide a playable move\n"; return currentState; }									   // Evaluate moves, if evaluation is not finished return from function
+		if (!hasCurrentSearch || currentSearchBoard != _exchange.board)								//
+		{																							//
+			currentSearch = p4ai::searchEngine.start(_exchange.board, searchDepth, moveBudgetMs);		//
+			currentSearchBoard = _exchange.board;													//
+			hasCurrentSearch = true;																//
+		}																							// Submit the position to the engine once, it searches on its own thread
 
-		ff::log() << "Thinking finished, time to move...\n";
+		p4ai::boardEvaluation eval;
+		p4ai::principalVariation line;
+		p4ai::searchStats stats;
+		p4ai::nSearchState searchState = p4ai::searchEngine.poll(currentSearch, eval, &line, &stats);																			 //
+		if (searchState == p4ai::nSearchState::cancelled) { hasCurrentSearch = false; return currentState; }													 //
+		if (searchState != p4ai::nSearchState::finished) { ff::log() << "Evaluating moves... Current: " << eval.getString() << "\n"; return currentState; }	 //
+		hasCurrentSearch = false;																																 //
+		if (!eval.isPlayable()) { ff::log() << "Evaluation does not provide a playable move\n"; return currentState; }											 // Poll the engine without blocking, if the search is not finished return from function
+
+		ff::log() << "Thinking finished, time to move... Expected line: " << line.getString() << "\n";
+		ff::log() << "Search: " << stats.getString() << "\n";
 
 		_dobot.ping();
 		if (_dobot.isConnected())
@@ -124,6 +147,8 @@ p4::states::nState p4::states::tick(dobot& _dobot, cvimage& _debugImg, uiExchang
 	{
 		ff::log() << "Waiting for player...\n";
 
+		if (_exchange.board.getTurn() == nBoardTurn::firstPlayer && _exchange.board.getStatus() == nBoardStatus::playing) { p4ai::searchEngine.ponder(_exchange.board, searchDepth); } // Explore the player's possible moves while waiting (does nothing if already pondering this board)
+
 		// Accept new moves:
 		if (imgBitboardIsValid && imgBitboard.getStatus() != nBoardStatus::invalid && imgBitboard.getTurnsPlayed() > _exchange.board.getTurnsPlayed())
 		{
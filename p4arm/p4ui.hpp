@@ -11,6 +11,7 @@
 
 
 #include "bitboard.hpp"
+#include "aiEngine.hpp"
 #include "uirelativepos.hpp"
 #include "uidrawable.hpp"
 
@@ -303,6 +304,7 @@ void p4ui::initializeP4()
 		[](ff::id<entity> _id, ff::eventClickRelease _event)->bool //
 		{														   //
 			board = bitboard();									   // (<- reset the board)
+			p4ai::searchEngine.newGame();						   // (<- results of the previous game lose their priority in the engine)
 			return true;										   //
 		}														   // Define a function for when the restart button is pressed
 	);
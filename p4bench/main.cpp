@@ -0,0 +1,90 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "aiBenchmark.hpp"
+
+
+/// \brief Node counts and thread scaling of depth-limited searches on a few middle-game positions
+int runSearchBenchmarks()
+{
+	// Middle-game positions (moves are columns [1, 7]):
+	const char* positions[] = { "4453", "44444326", "3344425", "4455332", "43444235", "2363466" };
+	const uint depth = 14;
+
+	ff::dynarray<bitboard> boards;
+	for (uint i = 0; i < sizeof(positions) / sizeof(positions[0]); i += 1)
+	{
+		bitboard board;
+		if (!board.playMoves(positions[i])) { ff::log() << "Invalid position: " << positions[i] << "\n"; continue; }
+		boards.pushback(board);
+	}
+
+	p4ai::benchmark::logTranspositionUsage(boards, depth);
+	p4ai::benchmark::logMoveOrdering(boards, depth);
+	p4ai::benchmark::logMoveHistory(boards, depth);
+	p4ai::benchmark::logWarmStart(boards, depth, "warmstart.bin");
+
+	uint maxThreads = ff::maxOf(std::thread::hardware_concurrency(), (uint)1);
+	p4ai::benchmark::logThreadScaling(boards, depth, maxThreads, p4ai::nParallelMode::lazySmp);
+	p4ai::benchmark::logThreadScaling(boards, depth, maxThreads, p4ai::nParallelMode::youngBrothersWait);
+
+	return 0;
+}
+
+/// \brief Solve every bundled position set (<stage>_<difficulty>.txt) and check the scores against the known exact ones, then compare the proof-number search to the negamax search on the won end games (end_wins.txt), and check the time manager
+///
+/// \return 0 if every position was solved with its exact score and every time manager check passed
+int runSolverSuite(const ff::string& _directory, uint _threadCount, uint _timeoutMs)
+{
+	const char* stages[] = { "early", "middle", "end" };
+	const char* difficulties[] = { "easy", "medium", "hard" };
+
+	ff::log() << "Solving the positions of " << _directory << " on " << _threadCount << " threads, " << _timeoutMs << " ms per position\n";
+
+	uint count = 0;
+	uint failed = 0;
+	ff::timer timer;
+	for (uint i = 0; i < sizeof(stages) / sizeof(stages[0]); i += 1)
+	{
+		for (uint j = 0; j < sizeof(difficulties) / sizeof(difficulties[0]); j += 1)
+		{
+			ff::string name = ff::string(stages[i]) + "_" + difficulties[j];
+			ff::string path = _directory + "/" + name + ".txt";
+
+			ff::dynarray<p4ai::benchmark::scoredPosition> positions;
+			if (!p4ai::benchmark::loadScoredPositions(path, positions)) { ff::log() << "Could not read " << path << "\n"; return 1; }
+
+			count += positions.size();
+			failed += p4ai::benchmark::logSolvedSet(name, positions, _threadCount, _timeoutMs);
+		}
+	}
+
+	// Proof-number search against negamax, on positions decided by threats:
+	ff::dynarray<p4ai::benchmark::scoredPosition> wins;
+	if (!p4ai::benchmark::loadScoredPositions(_directory + "/end_wins.txt", wins)) { ff::log() << "Could not read " << _directory << "/end_wins.txt\n"; return 1; }
+	count += wins.size();
+	failed += p4ai::benchmark::logProofNumberSet("end_wins", wins, p4ai::solver::defaultProofNodes, _timeoutMs);
+
+	// Time manager transitions (no search):
+	uint checkCount = 0;
+	failed += p4ai::benchmark::logTimeManagerChecks(checkCount);
+	count += checkCount;
+
+	ff::log() << "Total: " << count - failed << "/" << count << " passed in " << timer.getMilli() / 1000 << " s\n";
+	return (failed == 0) ? 0 : 1;
+}
+
+
+/// \brief Benchmarks of the AI, headless (no camera, robot or window)
+/// \detail Usage: p4bench [positions directory = positions] [threads = 1] [timeout per position in ms = 60000]
+///         p4bench search (depth-limited searches, see runSearchBenchmarks())
+int main(int _argc, char** _argv)
+{
+	if (_argc > 1 && std::strcmp(_argv[1], "search") == 0) { return runSearchBenchmarks(); }
+
+	ff::string directory = (_argc > 1) ? ff::string(_argv[1]) : ff::string("positions");
+	uint threadCount = (_argc > 2) ? (uint)std::atoi(_argv[2]) : 1;
+	uint timeoutMs = (_argc > 3) ? (uint)std::atoi(_argv[3]) : 60000;
+
+	return runSolverSuite(directory, ff::maxOf(threadCount, (uint)1), timeoutMs);
+}
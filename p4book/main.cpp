@@ -0,0 +1,28 @@
+#include <cstdlib>
+
+#include "aiOpeningBook.hpp"
+
+
+/// \brief Opening book generator
+/// \detail Usage: p4book [output file = openingbook.bin] [max ply = 12] [search depth = 42] [threads = all]
+int main(int _argc, char** _argv)
+{
+	ff::string path = (_argc > 1) ? ff::string(_argv[1]) : ff::string("openingbook.bin");
+	uint maxPly = (_argc > 2) ? (uint)std::atoi(_argv[2]) : 12;
+	uint searchDepth = (_argc > 3) ? (uint)std::atoi(_argv[3]) : 42;
+	uint threadCount = (_argc > 4) ? (uint)std::atoi(_argv[4]) : ff::maxOf(std::thread::hardware_concurrency(), (uint)1);
+
+	ff::log() << "Generating " << path << ": positions up to ply " << maxPly << ", searched at depth " << searchDepth << " on " << threadCount << " threads\n";
+
+	ff::timer timer;
+	uint64 recordCount = p4ai::generateOpeningBook(path, maxPly, searchDepth, threadCount);
+	if (recordCount == 0) { ff::log() << "Could not write " << path << "\n"; return 1; }
+
+	ff::log() << "Wrote " << recordCount << " positions in " << timer.getMilli() / 1000 << " s\n";
+
+	// Check that the file reads back:
+	p4ai::openingBook check;
+	if (!check.load(path) || check.recordCount != recordCount) { ff::log() << "Invalid book file\n"; return 1; }
+
+	return 0;
+}
@@ -0,0 +1,219 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#include "aiEngine.hpp"
+
+
+/// \brief Limits of a search submitted with go (0: no limit)
+struct searchLimits
+{
+	uint depth = 0;
+	uint moveTimeMs = 0;
+	uint64 nodes = 0;
+};
+
+/// \brief Session of the text protocol: commands are read on the main thread, the running search is reported by its own thread
+/// \detail Only one search runs at a time, like in the engine: commands that change the search (position, go, threads, solve) wait for the running search to end, send stop first to interrupt it
+struct protocolSession
+{
+	/// \brief Time between two polls of the running search
+	static const uint pollMs = 5;
+
+	/// \brief Budget given to the engine when the search has no time limit (the time manager only stops such a search on a proven win, see p4ai::timeManager)
+	static const uint unlimitedBudgetMs = 1 << 28;
+
+	bitboard board;
+	std::mutex outputLock;			// (<- lines are written by the main thread and the reporter)
+	std::thread reporter;
+	std::atomic<bool> stopRequested;
+
+	protocolSession() { stopRequested.store(false); }
+
+	/// \brief Write a line on stdout
+	void send(const std::string& _line);
+
+	/// \brief Run a command line
+	///
+	/// \return False once the session has to end (quit)
+	bool runCommand(const std::string& _line);
+
+	/// \brief Submit the current position to the engine and report it until it ends
+	void go(const searchLimits& _limits);
+
+	/// \brief Stop the running search, returns once its best move is reported (does nothing if no search runs)
+	void stop();
+
+	/// \brief Wait until the running search reaches one of its limits and its best move is reported (does nothing if no search runs)
+	void wait();
+
+	/// \brief Poll a search, send an info line every time its result changes, and its best move once it is finished or a limit is reached (reporter thread)
+	void report(p4ai::searchHandle _handle, searchLimits _limits);
+};
+
+
+/// \brief Standalone engine speaking a line-based text protocol on stdin / stdout, without the camera, robot or window
+/// \detail Commands (one per line, columns are [1, 7]):
+/// - position [moves]: set the position reached by playing the moves from the empty board (for example "position 4453")
+/// - go [depth <d>] [movetime <ms>] [nodes <n>]: search the position until one of the limits is reached or until stop (no limit: until every depth to the end of the game is explored, or a win is proven)
+///   movetime is the budget of the engine's time manager (it may play sooner on a stable or won position, see p4ai::timeManager) and is never exceeded, nodes is counted by the engine on every thread of the search
+/// - stop: stop the search, its best move is reported right away (the commands that change the search wait for the running one to end otherwise: a script can send its commands one after the other)
+/// - threads <n>, solve <on | off>: engine settings, applied to the next search (see p4ai::engine::setThreadCount(), p4ai::engine::setSolveMode())
+/// - isready: answered by readyok once the commands before it are processed
+/// - quit
+/// Replies:
+/// - info depth <d> score <s> nodes <n> nps <n> time <ms> pv <columns>: every time the result of the search changes (scores are the ones of the player to move)
+/// - bestmove <column>: once per go, when the search ends (bestmove none if the game is over)
+/// - error <message>: the command was not understood
+int main()
+{
+	p4ai::book.load("openingbook.bin"); // (<- optional, the engine searches every position without it)
+
+	protocolSession session;
+	std::string line;
+	bool quit = false;
+	while (!quit && std::getline(std::cin, line))
+	{
+		if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+		quit = !session.runCommand(line);
+	}
+
+	if (quit) { session.stop(); }
+	else { session.wait(); } // (<- end of the input, for example a script piping its commands: the last search is reported in full)
+
+	return 0;
+}
+
+
+
+void protocolSession::send(const std::string& _line)
+{
+	std::lock_guard<std::mutex> lock(outputLock);
+	std::cout << _line << std::endl; // (<- flushed: the other end of the pipe waits for whole lines)
+}
+bool protocolSession::runCommand(const std::string& _line)
+{
+	std::istringstream words(_line);
+	std::string command;
+	if (!(words >> command)) { return true; } // (<- empty line)
+
+	if (command == "quit") { return false; }
+	if (command == "isready") { send("readyok"); return true; }
+	if (command == "stop") { stop(); return true; }
+
+	if (command == "position" || command == "go" || command == "threads" || command == "solve") { wait(); }
+
+	if (command == "position")
+	{
+		std::string moves;
+		words >> moves;
+		bitboard position;
+		if (!position.playMoves(moves.c_str())) { send("error invalid moves: " + moves); return true; }
+		board = position;
+		return true;
+	}
+
+	if (command == "go")
+	{
+		searchLimits limits;
+		std::string name;
+		while (words >> name)
+		{
+			uint64 value = 0;
+			if (!(words >> value)) { send("error missing value of " + name); return true; }
+
+			if (name == "depth") { limits.depth = (uint)value; }
+			else if (name == "movetime") { limits.moveTimeMs = (uint)value; }
+			else if (name == "nodes") { limits.nodes = value; }
+			else { send("error unknown limit: " + name); return true; }
+		}
+		go(limits);
+		return true;
+	}
+
+	if (command == "threads")
+	{
+		uint threadCount = 0;
+		if (!(words >> threadCount) || threadCount == 0) { send("error invalid thread count"); return true; }
+		p4ai::searchEngine.setThreadCount(threadCount);
+		return true;
+	}
+
+	if (command == "solve")
+	{
+		std::string value;
+		words >> value;
+		if (value != "on" && value != "off") { send("error solve expects on or off"); return true; }
+		p4ai::searchEngine.setSolveMode(value == "on");
+		return true;
+	}
+
+	send("error unknown command: " + command);
+	return true;
+}
+void protocolSession::go(const searchLimits& _limits)
+{
+	if (board.getStatus() != nBoardStatus::playing) { send("bestmove none"); return; }
+
+	uint depth = (_limits.depth > 0) ? _limits.depth : bitboard::xSize * bitboard::ySize;
+	uint budgetMs = (_limits.moveTimeMs > 0) ? _limits.moveTimeMs : unlimitedBudgetMs;
+	p4ai::searchHandle handle = p4ai::searchEngine.start(board, depth, budgetMs, _limits.nodes);
+	stopRequested.store(false);
+	reporter = std::thread(&protocolSession::report, this, handle, _limits);
+}
+void protocolSession::stop()
+{
+	if (!reporter.joinable()) { return; }
+	stopRequested.store(true);
+	reporter.join();
+}
+void protocolSession::wait()
+{
+	if (reporter.joinable()) { reporter.join(); }
+}
+void protocolSession::report(p4ai::searchHandle _handle, searchLimits _limits)
+{
+	ff::timer timer;
+	p4ai::boardEvaluation reported = p4ai::boardEvaluation(p4ai::nEvaluation::aborted);
+	uint reportedDepth = 0;
+	while (true)
+	{
+		p4ai::boardEvaluation eval;
+		p4ai::principalVariation line;
+		p4ai::searchStats stats;
+		p4ai::nSearchState state = p4ai::searchEngine.poll(_handle, eval, &line, &stats);
+
+		// Info line every time a depth is finished or the result changes:
+		if (eval.isPlayable() && (stats.depth != reportedDepth || eval.score != reported.score || eval.column != reported.column))
+		{
+			uint timeMs = timer.getMilli();
+			std::ostringstream info;
+			info << "info depth " << stats.depth << " score " << (int)eval.score << " nodes " << stats.nodes << " nps " << stats.nodes * 1000 / ff::maxOf(timeMs, (uint)1) << " time " << timeMs << " pv " << line.getString().data();
+			send(info.str());
+			reported = eval;
+			reportedDepth = stats.depth;
+		}
+
+		bool limitReached = stopRequested.load() || (_limits.moveTimeMs > 0 && timer.waitedForMilli(_limits.moveTimeMs)) || (_limits.nodes > 0 && stats.nodes >= _limits.nodes);
+		if (state == p4ai::nSearchState::finished || state == p4ai::nSearchState::cancelled || limitReached)
+		{
+			if (state != p4ai::nSearchState::finished) { p4ai::searchEngine.cancel(_handle); }
+
+			// Stopped before the first result: any move that does not lose right away
+			uint8 column = eval.isPlayable() ? eval.column : -1;
+			if (column == (uint8)-1)
+			{
+				uint64 moves = board.possibleNonLosingMoves();
+				if (moves == 0) { moves = board.getPossibleMoves(); }
+				for (uint x = 0; x < bitboard::xSize && column == (uint8)-1; x += 1) { if ((moves & ops::getColumnMask(x)) != 0) { column = x; } }
+			}
+			send("bestmove " + std::to_string((int)column + 1));
+			return;
+		}
+
+		ff::sleep(pollMs);
+	}
+}